@@ -1,13 +1,12 @@
 #include "dna.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <exception>
 #include <fstream>
 #include <functional>
-#include <queue>
 #include <string>
-#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -20,11 +19,15 @@
 #include "point.h"
 #include "progress.h"
 #include "range.h"
+#include "sequence_key.h"
+#include "sequence_reader.h"
 #include "utils.h"
 
+using std::array;
 using std::endl;
 using std::greater;
 using std::ifstream;
+using std::lower_bound;
 using std::max;
 using std::max_element;
 using std::min;
@@ -32,62 +35,107 @@ using std::move;
 using std::ofstream;
 using std::out_of_range;
 using std::pair;
-using std::priority_queue;
+using std::sort;
+using std::stable_sort;
 using std::string;
 using std::swap;
 using std::to_string;
-using std::tuple;
+using std::unique;
 using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 
 bool Dna::Import(const string& filename) {
-  ifstream in_file(filename);
-  if (!in_file) {
+  SequenceReader reader(filename);
+  if (!reader) {
     return false;
   }
 
-  while (!in_file.eof()) {
-    string key, value;
-
-    in_file >> key >> value;
-    if (key.length() <= 1) break;
-
-    key = key.substr(1);
-    data_[key] = value;
-
-    auto density_size = value.size() + Config::PADDING_SIZE;
-    ins_deltas_.density_[key].resize(density_size);
-    del_deltas_.density_[key].resize(density_size);
+  SequenceReader::Record record;
+  while (reader.Read(&record)) {
+    const auto& [key, value] = record;
+    auto key_id = SequenceKey::Intern(key);
+    data_[key_id] = Sequence(value);
   }
 
-  in_file.close();
-  return true;
+  return static_cast<bool>(reader);
 }
 
 bool Dna::ImportIndex(const string& filename) {
+  if (DnaIndex::IsBinary(filename)) {
+    return ImportBinaryIndex(filename);
+  }
+
+  // Fall back to the text format of earlier versions.
   ifstream in_file(filename);
   if (!in_file) {
     Logger::Error("Dna::ImportIndex", "Input file " + filename + " not found");
     return false;
   }
+  if (Config::CANONICAL_KMERS) {
+    Logger::Error("Dna::ImportIndex", "Text index has no canonical k-mers");
+    return false;
+  }
 
+  unordered_map<string, uint32_t> key_ids;
   while (!in_file.eof()) {
     uint64_t hash = 0;
     string key;
     size_t start, end;
 
     in_file >> hash >> key >> start >> end;
-    if (!hash || !key.length()) break;
+    if (!key.length()) break;
 
-    Range range{start, end, &(this->data_.at(key))};
-    range_index_.emplace(hash, pair{key, range});
+    if (end != start + Config::HASH_SIZE) {
+      Logger::Error(
+          "Dna::ImportIndex", "Index of hash size " + to_string(end - start));
+      return false;
+    }
+    if (!key_ids.count(key)) {
+      const auto& value = this->data_.at(SequenceKey::Find(key));
+      key_ids[key] = index_.AddKey(key, &value);
+    }
+    index_.Insert(hash, key_ids[key], start);
   }
+  index_.Build();
 
   in_file.close();
   return true;
 }
 
+bool Dna::ImportBinaryIndex(const string& filename) {
+  // Load into a new index first, so that a mismatched file leaves the current
+  // index untouched.
+  DnaIndex index;
+  if (!index.Load(filename)) return false;
+
+  for (uint32_t key_id = 0; key_id < index.key_count(); ++key_id) {
+    const auto& key = index.key(key_id);
+    auto value_i = data_.find(SequenceKey::Find(key));
+    if (value_i == data_.end()) {
+      Logger::Error("Dna::ImportIndex", "Unknown chromosome " + key);
+      return false;
+    }
+    index.AddKey(key, &value_i->second);
+  }
+  if (index.Checksum() != index.checksum()) {
+    Logger::Error(
+        "Dna::ImportIndex", "Index not created from this reference data");
+    return false;
+  }
+  if (!index.CheckEntries()) {
+    Logger::Error("Dna::ImportIndex", "Index entries out of range");
+    return false;
+  }
+
+  if (index_.size()) {
+    index_.Merge(index);
+  } else {
+    index_.swap(index);
+  }
+  return true;
+}
+
 bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
   ifstream in_file(filename);
   if (!in_file) {
@@ -95,14 +143,16 @@ bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
   }
 
   while (!in_file.eof()) {
-    string key_ref, key_seg;
+    string name_ref, name_seg;
     int64_t start_ref, end_ref;
     int64_t start_seg, end_seg;
 
-    in_file >> key_ref >> start_ref >> end_ref;
-    in_file >> key_seg >> start_seg >> end_seg;
-    if (!key_ref.length() || !key_seg.length()) break;
+    in_file >> name_ref >> start_ref >> end_ref;
+    in_file >> name_seg >> start_seg >> end_seg;
+    if (!name_ref.length() || !name_seg.length()) break;
 
+    auto key_ref = SequenceKey::Find(name_ref);
+    auto key_seg = SequenceKey::Intern(name_seg);
     const auto& value_ref = this->data_.at(key_ref);
     // Invert the segment chain if marked inverted.
     auto&& value_seg = segments_p->data_[key_seg];
@@ -117,7 +167,7 @@ bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
       mode |= 1;
       swap(start_seg, end_seg);
     }
-    value_seg = Transform(value_seg, static_cast<Mode>(mode));
+    value_seg.Transform(static_cast<Mode>(mode));
 
     Range range_ref{
         static_cast<size_t>(start_ref),
@@ -130,7 +180,7 @@ bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
         &value_seg,
     };
 
-    Logger::Trace("Dna::ImportOverlaps " + key_ref, "Minimizer:");
+    Logger::Trace("Dna::ImportOverlaps " + name_ref, "Minimizer:");
     Logger::Trace("", "REF: \t" + range_ref.Head());
     Logger::Trace("", "SEG: \t" + range_seg.Head());
 
@@ -139,7 +189,7 @@ bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
     } else {
       Logger::Warn(
           "Dna::ImportOverlaps",
-          key_ref + " " + key_seg + " minimizer not matched");
+          name_ref + " " + name_seg + " minimizer not matched");
     }
   }
 
@@ -147,6 +197,13 @@ bool Dna::ImportOverlaps(Dna* segments_p, const string& filename) {
   return true;
 }
 
+// Take the overlaps found by segments_p->FindOverlaps(*this), whose segments
+// are transformed and verified already by MapReads.
+void Dna::ImportOverlaps(Dna* segments_p) {
+  overlaps_ = move(segments_p->overlaps_);
+  segments_p->overlaps_ = DnaOverlap();
+}
+
 bool Dna::Print(const string& filename) const {
   ofstream out_file(filename);
   if (!out_file) {
@@ -155,168 +212,469 @@ bool Dna::Print(const string& filename) const {
   }
 
   for (const auto& [key, value] : data_) {
-    out_file << ">" << key << "\n" << value << endl;
+    out_file << ">" << SequenceKey::Name(key) << "\n"
+             << value.substr() << endl;
   }
 
   out_file.close();
   return true;
 }
 
-uint64_t Dna::NextHash(uint64_t hash, char next_base) {
-  const unordered_map<char, char> dna_base_map{
-      {'A', 0},
-      {'T', 1},
-      {'C', 2},
-      {'G', 3},
-      {'N', 0},
-  };
-  const uint64_t mask = ~(UINT64_MAX << (Config::HASH_SIZE << 1));
-  return ((hash << 2) & mask) | dna_base_map.at(next_base);
+namespace {
+
+// 2-bit codes of the bases and of their complements, indexed by character.
+// Unknown bases are 0 either way, as 'N' is its own complement.
+constexpr auto BASE_CODES = []() {
+  array<uint8_t, 256> codes{};
+  codes['T'] = 1;
+  codes['C'] = 2;
+  codes['G'] = 3;
+  return codes;
+}();
+
+constexpr auto COMPLEMENT_CODES = []() {
+  array<uint8_t, 256> codes{};
+  codes['A'] = 1;
+  codes['G'] = 2;
+  codes['C'] = 3;
+  return codes;
+}();
+
+inline uint64_t HashMask() {
+  return ~(UINT64_MAX << (Config::HASH_SIZE << 1));
 }
 
-struct HashPos {
-  HashPos() {}
-  HashPos(uint64_t hash, size_t pos) : hash_(hash), pos_(pos) {}
+// Erase the deltas marked as removed, keeping the others in order.
+void EraseRemoved(vector<Minimizer>* deltas_p, const vector<bool>& removed) {
+  auto&& deltas = *deltas_p;
+  size_t end = 0;
+  for (size_t pos = 0; pos < deltas.size(); ++pos) {
+    if (!removed[pos]) deltas[end++] = move(deltas[pos]);
+  }
+  deltas.resize(end);
+}
 
-  bool operator<(const HashPos& that) const { return hash_ > that.hash_; }
+}  // namespace
 
-  uint64_t hash_ = 0;
-  size_t pos_ = 0;
-};
+uint64_t Dna::NextHash(uint64_t hash, char next_base) {
+  auto code = BASE_CODES[static_cast<uint8_t>(next_base)];
+  return ((hash << 2) & HashMask()) | code;
+}
 
-void Dna::CreateIndex() {
-  assert(Config::HASH_SIZE > 0 && Config::HASH_SIZE <= 30);
-  unordered_map<string, size_t> index_count;
+// Hashes of all k-mers in chain, where hashes[i] is the hash of
+// chain[i, i + Config::HASH_SIZE).
+void Dna::RollHashes(const string& chain, vector<uint64_t>* hashes_p) {
+  auto&& hashes = *hashes_p;
+  hashes.clear();
+  if (chain.size() < Config::HASH_SIZE) return;
+  hashes.resize(chain.size() - Config::HASH_SIZE + 1);
+
+  auto mask = HashMask();
+  auto chain_p = reinterpret_cast<const uint8_t*>(chain.data());
+  uint64_t hash = 0;
+  for (size_t i = 0; i < Config::HASH_SIZE - 1; ++i) {
+    hash = (hash << 2) | BASE_CODES[chain_p[i]];
+  }
 
-  for (const auto& [key_ref, value_ref] : data_) {
-    uint64_t hash = 0;
-    for (size_t i = 0; i < Config::HASH_SIZE - 1; ++i) {
-      hash = NextHash(hash, value_ref[i]);
+  chain_p += Config::HASH_SIZE - 1;
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    hash = ((hash << 2) & mask) | BASE_CODES[chain_p[i]];
+    hashes[i] = hash;
+  }
+}
+
+// Hashes of the k-mers of value starting in [start, end). With
+// Config::CANONICAL_KMERS, each hash is the smaller one of the k-mer and its
+// reverse complement, shifted left by a strand bit which is set if the
+// reverse complement is the smaller one.
+void Dna::RollHashes(
+    const Sequence& value,
+    size_t start,
+    size_t end,
+    vector<uint64_t>* hashes_p) {
+  auto&& hashes = *hashes_p;
+  end = min(end, max(value.size() + 1, Config::HASH_SIZE) - Config::HASH_SIZE);
+  hashes.clear();
+  if (start >= end) return;
+  hashes.resize(end - start);
+
+  auto mask = HashMask();
+  auto high = (Config::HASH_SIZE - 1) << 1;
+  uint64_t hash = 0, rc_hash = 0;
+  auto next = [&](size_t pos) {
+    auto code = value.code(pos);
+    hash = ((hash << 2) & mask) | code;
+    if (Config::CANONICAL_KMERS) {
+      auto rc_code = value.IsUnknown(pos) ? 0 : code ^ 1;
+      rc_hash = (rc_hash >> 2) | (rc_code << high);
     }
+  };
 
-    priority_queue<HashPos> hashes;
-    HashPos prev_min_hash;
-    auto i_end = value_ref.length() - Config::HASH_SIZE + 1;
-    Progress progress{"Dna::CreateIndex " + key_ref, i_end, 10000};
+  for (size_t i = 0; i < Config::HASH_SIZE - 1; ++i) next(start + i);
 
-    for (size_t i = 0; i < i_end; ++i) {
-      while (hashes.size() && hashes.top().pos_ + Config::WINDOW_SIZE <= i) {
-        hashes.pop();
-      }
-      hash = NextHash(hash, value_ref[i + Config::HASH_SIZE - 1]);
-      hashes.emplace(hash, i);
+  auto code_start = start + Config::HASH_SIZE - 1;
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    next(code_start + i);
+    if (Config::CANONICAL_KMERS) {
+      hashes[i] = (min(hash, rc_hash) << 1) | (rc_hash < hash);
+    } else {
+      hashes[i] = hash;
+    }
+  }
+}
 
-      auto min_hash = hashes.top();
-      if (min_hash.pos_ != prev_min_hash.pos_) {
-        Range range_ref{
-            min_hash.pos_,
-            min_hash.pos_ + Config::HASH_SIZE,
-            &value_ref,
-        };
-        range_index_.emplace(min_hash.hash_, pair{key_ref, range_ref});
-        prev_min_hash = min_hash;
-        ++index_count[key_ref];
+/**
+ * Hashes of the k-mers of chain in all modes, computed in a single pass.
+ * hashes[mode][i] is the hash of the k-mer at position i of
+ * Transform(chain, mode).
+ */
+void Dna::RollModeHashes(
+    const string& chain, array<vector<uint64_t>, 4>* hashes_p) {
+  auto&& hashes = *hashes_p;
+  for (auto&& mode_hashes : hashes) mode_hashes.clear();
+  if (chain.size() < Config::HASH_SIZE) return;
+  auto count = chain.size() - Config::HASH_SIZE + 1;
+  for (auto&& mode_hashes : hashes) mode_hashes.resize(count);
+
+  auto mask = HashMask();
+  auto high = (Config::HASH_SIZE - 1) << 1;
+  uint64_t hash = 0, rev_hash = 0, comp_hash = 0, rc_hash = 0;
+  for (size_t i = 0; i < chain.size(); ++i) {
+    auto base = static_cast<uint8_t>(chain[i]);
+    uint64_t code = BASE_CODES[base];
+    uint64_t comp_code = COMPLEMENT_CODES[base];
+    hash = ((hash << 2) & mask) | code;
+    comp_hash = ((comp_hash << 2) & mask) | comp_code;
+    rev_hash = (rev_hash >> 2) | (code << high);
+    rc_hash = (rc_hash >> 2) | (comp_code << high);
+    if (i + 1 < Config::HASH_SIZE) continue;
+
+    // Reversed modes read the chain backwards.
+    auto pos = i + 1 - Config::HASH_SIZE;
+    hashes[NORMAL][pos] = hash;
+    hashes[COMPLEMENT][pos] = comp_hash;
+    hashes[REVERSE][count - 1 - pos] = rev_hash;
+    hashes[REVR_COMP][count - 1 - pos] = rc_hash;
+  }
+}
 
-        Logger::Trace(
-            "Dna::CreateIndex",
-            "Saved " + range_ref.get() + " " + to_string(min_hash.hash_));
-      }
+/**
+ * Find the minimizers of value, i.e. the smallest hash in each window of
+ * Config::WINDOW_SIZE consecutive k-mers, taking the leftmost one on ties.
+ * A minimizer shared by several windows is reported once.
+ *
+ * Candidates are kept in a monotone queue, where hashes increase from front
+ * to back. Each k-mer enters and leaves the queue at most once, so it takes
+ * amortized O(1) time per base. The queue never holds more than a window, so
+ * it lives in a small ring buffer.
+ */
+vector<pair<uint64_t, size_t>> Dna::FindMinimizers(const Sequence& value) {
+  assert(Config::HASH_SIZE > 0 && Config::HASH_SIZE <= 30);
+  assert(Config::WINDOW_SIZE > 0);
+  vector<pair<uint64_t, size_t>> minimizers;
+  if (value.size() < Config::HASH_SIZE) return minimizers;
+
+  size_t capacity = 1;
+  while (capacity < Config::WINDOW_SIZE) capacity <<= 1;
+  vector<pair<uint64_t, size_t>> queue(capacity);
+  auto mask = capacity - 1;
+  size_t front = 0, back = 0;
+
+  // Hashes are rolled in blocks, to keep the buffer small on long chromosomes.
+  const size_t block_size = 1 << 16;
+  vector<uint64_t> hashes;
+
+  size_t prev_min_pos = 0;
+  auto i_end = value.size() - Config::HASH_SIZE + 1;
+  for (size_t i = 0; i < i_end; ++i) {
+    if (i % block_size == 0) RollHashes(value, i, i + block_size, &hashes);
+    auto hash = hashes[i % block_size];
+
+    if (front != back &&
+        queue[front & mask].second + Config::WINDOW_SIZE <= i) {
+      ++front;
+    }
+    while (front != back && queue[(back - 1) & mask].first > hash) --back;
+    queue[back++ & mask] = {hash, i};
+
+    // As before, a minimizer at position 0 is never reported.
+    const auto& min_hash = queue[front & mask];
+    if (min_hash.second != prev_min_pos) {
+      minimizers.push_back(min_hash);
+      prev_min_pos = min_hash.second;
+    }
+  }
+  return minimizers;
+}
 
-      ++progress;
+void Dna::CreateIndex() {
+  Progress progress{"Dna::CreateIndex", data_.size()};
+  for (const auto& [key_ref, value_ref] : data_) {
+    const auto& name_ref = SequenceKey::Name(key_ref);
+    auto key_id = index_.AddKey(name_ref, &value_ref);
+    auto minimizers = FindMinimizers(value_ref);
+
+    for (const auto& [hash, pos] : minimizers) {
+      index_.Insert(hash, key_id, pos);
+      Logger::Trace(
+          "Dna::CreateIndex",
+          "Saved " + value_ref.substr(pos, Config::HASH_SIZE) + " " +
+              to_string(hash));
     }
 
     Logger::Debug(
-        "Dna::CreateIndex " + key_ref,
-        "Count: " + to_string(index_count[key_ref]));
+        "Dna::CreateIndex " + name_ref,
+        "Count: " + to_string(minimizers.size()));
+    ++progress;
   }
+
+  index_.Build();
 }
 
 bool Dna::PrintIndex(const string& filename) const {
-  ofstream out_file(filename);
-  if (!out_file) {
-    Logger::Error("Dna::PrintIndex", "Cannot create output file " + filename);
+  return index_.Save(filename);
+}
+
+bool Dna::FindOverlaps(const Dna& ref) {
+  vector<KeyId> key_segs;
+  vector<pair<string, Sequence*>> reads;
+  for (auto&& [key_seg, value_seg] : data_) {
+    key_segs.push_back(key_seg);
+    reads.emplace_back(SequenceKey::Name(key_seg), &value_seg);
+  }
+
+  Progress progress{"Dna::FindOverlaps", reads.size(), 100};
+  vector<DnaOverlap> read_overlaps;
+  if (!MapReads(ref, reads, &read_overlaps, &progress)) return false;
+  for (size_t i = 0; i < reads.size(); ++i) {
+    overlaps_.Add(key_segs[i], *reads[i].second, read_overlaps[i]);
+  }
+
+  overlaps_.SelectChain();
+  overlaps_.CheckCoverage();
+  return true;
+}
+
+/**
+ * Map the reads of a FASTA or FASTQ file, loading Config::READ_BATCH_SIZE
+ * bases at a time into buffers reused by each batch. Only mapped reads are
+ * named and kept: whole, 2-bit packed, if keep_reads is set, since aligning
+ * them reads them through range_seg, or else by their length only, which is
+ * enough to print the overlaps. A read named like an earlier mapped one is
+ * skipped, as the overlaps of both would refer to one read.
+ */
+bool Dna::FindOverlaps(
+    const Dna& ref, const string& filename, bool keep_reads) {
+  SequenceReader reader(filename);
+  if (!reader) {
+    Logger::Error("Dna::FindOverlaps", "Input file " + filename + " not found");
     return false;
   }
 
-  for (const auto& [hash, entry] : range_index_) {
-    const auto& [key_ref, range_ref] = entry;
-    out_file << hash << " " << range_ref.Stringify(key_ref) << "\n";
+  Progress progress{"Dna::FindOverlaps", reader.size()};
+  vector<SequenceReader::Record> records;
+  vector<Sequence> values;
+  vector<DnaOverlap> read_overlaps;
+  while (reader.Read(&records, Config::READ_BATCH_SIZE)) {
+    vector<pair<string, Sequence*>> reads;
+    values.resize(max(values.size(), records.size()));
+    for (size_t i = 0; i < records.size(); ++i) {
+      values[i].Assign(records[i].value_);
+      reads.emplace_back(records[i].key_, &values[i]);
+    }
+    if (!MapReads(ref, reads, &read_overlaps)) return false;
+
+    for (size_t i = 0; i < reads.size(); ++i) {
+      if (!read_overlaps[i].size()) continue;
+      const auto& name = reads[i].first;
+      auto key_seg = SequenceKey::Find(name);
+      if (key_seg != SequenceKey::NONE &&
+          (data_.count(key_seg) || overlaps_.seg_sizes_.count(key_seg))) {
+        Logger::Warn(
+            "Dna::FindOverlaps", "Duplicate read " + name + " skipped");
+        continue;
+      }
+
+      key_seg = SequenceKey::Intern(name);
+      if (keep_reads) {
+        auto&& value_seg = data_[key_seg] = move(values[i]);
+        overlaps_.Add(key_seg, value_seg, read_overlaps[i]);
+      } else {
+        overlaps_.Add(key_seg, values[i], read_overlaps[i], false);
+      }
+    }
+    progress.Set(reader.pos());
   }
+  if (!reader) return false;
 
-  out_file.close();
+  overlaps_.SelectChain();
+  overlaps_.CheckCoverage();
   return true;
 }
 
-bool Dna::FindOverlaps(const Dna& ref) {
-  if (!ref.range_index_.size()) {
+// Map named reads to ref. (*overlaps_p)[i] receives the merged overlaps of
+// reads[i], under no segment key, which the caller adds once it names them.
+bool Dna::MapReads(
+    const Dna& ref,
+    const vector<pair<string, Sequence*>>& reads,
+    vector<DnaOverlap>* overlaps_p,
+    Progress* progress_p) {
+  if (!ref.index_.size()) {
     Logger::Warn("Dna::FindOverlaps", "No index found in reference data");
     return false;
   }
   assert(Config::HASH_SIZE > 0 && Config::HASH_SIZE <= 30);
 
-  auto find_overlaps = [&](const string& key_seg,
-                           const string& raw_chain_seg,
-                           Mode mode) {
-    auto chain_seg = Transform(raw_chain_seg, mode);
-    assert(chain_seg.length() > 0);
-
-    uint64_t hash = 0;
-    for (size_t i = 0; i < Config::HASH_SIZE - 1; ++i) {
-      hash = NextHash(hash, chain_seg[i]);
-    }
+  // Ids of the chromosomes in the index, which numbers them on its own.
+  vector<KeyId> key_refs;
+  for (uint32_t key_id = 0; key_id < ref.index_.key_count(); ++key_id) {
+    key_refs.push_back(SequenceKey::Find(ref.index_.key(key_id)));
+  }
 
-    DnaOverlap overlaps;
-    for (size_t i = 0; i < chain_seg.length() - Config::HASH_SIZE + 1; ++i) {
-      hash = NextHash(hash, chain_seg[i + Config::HASH_SIZE - 1]);
+  // Repetitive minimizers would add many anchors to every read hitting them,
+  // while telling little about where the read belongs.
+  auto max_occurrence = ref.index_.max_occurrence();
+
+  auto find_overlaps = [&](KeyId key_seg,
+                           const Sequence& value_seg,
+                           const array<vector<uint64_t>, 4>& hashes) {
+    array<DnaOverlap, 4> overlaps;
+    auto insert_entries = [&](Mode mode,
+                              size_t i,
+                              const pair<const DnaIndex::Entry*,
+                                         const DnaIndex::Entry*>& entries) {
+      auto [entry_begin, entry_end] = entries;
+      auto occurrence = static_cast<size_t>(entry_end - entry_begin);
+      if (!occurrence || occurrence > max_occurrence) return;
+      Range range_seg{i, i + Config::HASH_SIZE, &value_seg, mode};
+
+      for (auto j = entry_begin; j != entry_end; ++j) {
+        auto key_ref = key_refs[j->key_id_];
+        Range range_ref{
+            j->start_,
+            j->start_ + Config::HASH_SIZE,
+            ref.index_.value(j->key_id_),
+        };
+        overlaps[mode].Insert(key_ref, {range_ref, key_seg, range_seg});
 
-      if (ref.range_index_.count(hash)) {
-        const auto& entry_ref_range = ref.range_index_.equal_range(hash);
-        Range range_seg{i, i + Config::HASH_SIZE, &raw_chain_seg, mode};
+        // Logger::Trace("Dna::FindOverlaps", key_ref + ": \tMinimizer:");
+        // Logger::Trace("", "REF: \t" + range_ref.get());
+        // Logger::Trace("", "SEG: \t" + range_seg.get());
+      }
+    };
 
-        for (auto j = entry_ref_range.first; j != entry_ref_range.second; ++j) {
-          const auto& [key_ref, range_ref] = j->second;
-          overlaps.Insert(key_ref, {range_ref, key_seg, range_seg});
+    if (!Config::CANONICAL_KMERS) {
+      for (auto mode : {NORMAL, REVERSE, COMPLEMENT, REVR_COMP}) {
+        for (size_t i = 0; i < hashes[mode].size(); ++i) {
+          insert_entries(mode, i, ref.index_.Find(hashes[mode][i]));
+        }
+      }
+      return overlaps;
+    }
 
-          // Logger::Trace("Dna::FindOverlaps", key_ref + ": \tMinimizer:");
-          // Logger::Trace("", "REF: \t" + range_ref.get());
-          // Logger::Trace("", "SEG: \t" + range_seg.get());
+    // A k-mer and its reverse complement share one canonical hash, and the
+    // strand bits of the hits tell which of the two modes they match in.
+    // Palindromes match in both. Both strands are adjacent in the index, so
+    // they are found with one search.
+    auto insert_canonical = [&](uint64_t hash,
+                                Mode mode,
+                                size_t i,
+                                uint64_t rc_hash,
+                                Mode rc_mode,
+                                size_t rc_i) {
+      uint64_t strand = rc_hash < hash;
+      auto entries = ref.index_.FindPair(min(hash, rc_hash) << 1);
+      for (uint64_t ref_strand : {0, 1}) {
+        if (hash == rc_hash || ref_strand == strand) {
+          insert_entries(mode, i, entries[ref_strand]);
+        }
+        if (hash == rc_hash || ref_strand != strand) {
+          insert_entries(rc_mode, rc_i, entries[ref_strand]);
         }
       }
+    };
+
+    auto count = hashes[NORMAL].size();
+    for (size_t i = 0; i < count; ++i) {
+      auto rc_i = count - 1 - i;
+      insert_canonical(
+          hashes[NORMAL][i],
+          NORMAL,
+          i,
+          hashes[REVR_COMP][rc_i],
+          REVR_COMP,
+          rc_i);
+      insert_canonical(
+          hashes[REVERSE][rc_i],
+          REVERSE,
+          rc_i,
+          hashes[COMPLEMENT][i],
+          COMPLEMENT,
+          i);
     }
     return overlaps;
   };
 
-  Progress progress{"Dna::FindOverlaps", data_.size(), 100};
-  for (auto&& [key_seg, value_seg] : data_) {
-    vector<DnaOverlap> overlaps_map;
-    for (auto mode : {NORMAL, REVERSE, COMPLEMENT, REVR_COMP}) {
-      overlaps_map.push_back(find_overlaps(key_seg, value_seg, mode));
-    }
+  // Reads are mapped in batches on worker threads. Each read collects its
+  // overlaps separately, and callers add them in order, so that the result
+  // doesn't depend on the thread count.
+  const size_t batch_size = 16;
+  auto batch_count = (reads.size() + batch_size - 1) / batch_size;
+  auto&& read_overlaps = *overlaps_p;
+  read_overlaps.assign(reads.size(), DnaOverlap());
+
+  // Anchors are chained per read, so that they never pile up across reads.
+  auto find_best_overlaps = [&](const string& name_seg,
+                                Sequence& value_seg,
+                                DnaOverlap* overlaps_p) {
+    auto raw_chain_seg = value_seg.substr();
+    array<vector<uint64_t>, 4> hashes;
+    RollModeHashes(raw_chain_seg, &hashes);
+    auto overlaps_map = find_overlaps(SequenceKey::NONE, value_seg, hashes);
 
     auto best_i = max_element(overlaps_map.begin(), overlaps_map.end());
 
     auto overlap_count = best_i->size();
     if (overlap_count < Config::OVERLAP_MIN_COUNT) {
       Logger::Trace(
-          "Dna::FindOverlaps " + key_seg,
+          "Dna::FindOverlaps " + name_seg,
           to_string(overlap_count) + " not used");
-    } else {
-      auto mode = static_cast<Mode>(best_i - overlaps_map.begin());
-      value_seg = Transform(value_seg, mode);
-      overlaps_ += *best_i;
-
-      Logger::Debug(
-          "Dna::FindOverlaps " + key_seg,
-          to_string(overlap_count) + " using mode: " + to_string(mode));
+      return;
     }
 
-    ++progress;
-  }
-
-  overlaps_.Merge();
-  overlaps_.SelectChain();
-  overlaps_.CheckCoverage();
+    auto mode = static_cast<Mode>(best_i - overlaps_map.begin());
+    value_seg.Transform(mode);
+    Logger::Debug(
+        "Dna::FindOverlaps " + name_seg,
+        to_string(overlap_count) + " using mode: " + to_string(mode));
+
+    // Drop chains whose first bases don't match, as imported overlaps are.
+    best_i->Merge();
+    for (auto&& [key_ref, entries] : best_i->data_) {
+      for (auto entry_i = entries.begin(); entry_i != entries.end();) {
+        const auto& [range_ref, key_seg, range_seg] = *entry_i;
+        if (Verify(range_ref, range_seg)) {
+          ++entry_i;
+          continue;
+        }
+        Logger::Warn(
+            "Dna::FindOverlaps",
+            SequenceKey::Name(key_ref) + " " + name_seg +
+                " minimizer not matched");
+        entry_i = entries.erase(entry_i);
+      }
+    }
+    swap(*overlaps_p, *best_i);
+  };
 
+  ParallelFor(batch_count, [&](size_t batch_i) {
+    auto end = min((batch_i + 1) * batch_size, reads.size());
+    for (auto i = batch_i * batch_size; i < end; ++i) {
+      const auto& [name_seg, value_seg_p] = reads[i];
+      find_best_overlaps(name_seg, *value_seg_p, &read_overlaps[i]);
+      if (progress_p) ++*progress_p;
+    }
+  });
   return true;
 }
 
@@ -334,15 +692,57 @@ bool Dna::PrintOverlaps(const string& filename) const {
   return true;
 }
 
+/**
+ * Align each chromosome of ref to the same one of sv, chunk by chunk. As a
+ * chunk starts where the previous one ends, chromosomes are first split into
+ * windows at anchors, which are aligned independently on all threads. Deltas
+ * of each window are buffered, and saved in order once all windows are done.
+ */
 void Dna::FindDeltas(const Dna& sv, size_t chunk_size) {
-  for (const auto& [key_ref, value_ref] : data_) {
+  struct Window {
+    KeyId key_ref_;
+    Point start_;
+    Point end_;
+    ChunkDeltas deltas_;
+  };
+
+  // Anchors of each chromosome are found on all threads at once, and windows
+  // are listed in the order of data_.
+  vector<KeyId> key_refs;
+  for (const auto& [key_ref, value_ref] : data_) key_refs.push_back(key_ref);
+  vector<vector<Point>> anchors(key_refs.size());
+  ParallelFor(key_refs.size(), [&](size_t key_i) {
+    auto key_ref = key_refs[key_i];
+    anchors[key_i] = FindAnchors(data_.at(key_ref), sv.data_.at(key_ref));
+  });
+
+  vector<Window> windows;
+  size_t total_length = 0;
+  for (size_t key_i = 0; key_i < key_refs.size(); ++key_i) {
+    auto key_ref = key_refs[key_i];
+    const auto& key_anchors = anchors[key_i];
+    for (size_t i = 1; i < key_anchors.size(); ++i) {
+      windows.push_back({key_ref, key_anchors[i - 1], key_anchors[i], {}});
+    }
+    total_length += data_.at(key_ref).length();
+
+    Logger::Debug(
+        "Dna::FindDeltas",
+        SequenceKey::Name(key_ref) + " " + to_string(key_anchors.size() - 2) +
+            " anchors");
+  }
+
+  Progress progress{"Dna::FindDeltas", total_length};
+  ParallelFor(windows.size(), [&](size_t window_i) {
+    auto&& [key_ref, start, end, deltas] = windows[window_i];
+    const auto& value_ref = data_.at(key_ref);
     const auto& value_sv = sv.data_.at(key_ref);
-    Progress progress{"Dna::FindDeltas " + key_ref, value_ref.length()};
+    size_t ref_end = end.x_;
+    size_t sv_end = end.y_;
 
-    for (size_t i = 0, j = 0;
-         i < value_ref.length() || j < value_sv.length();) {
-      auto m = min(value_ref.length() - i, chunk_size);
-      auto n = min(value_sv.length() - j, chunk_size);
+    for (size_t i = start.x_, j = start.y_; i < ref_end || j < sv_end;) {
+      auto m = min(ref_end - i, chunk_size);
+      auto n = min(sv_end - j, chunk_size);
       auto reach_start = true;
       auto reach_end = m < chunk_size || n < chunk_size;
 
@@ -356,105 +756,302 @@ void Dna::FindDeltas(const Dna& sv, size_t chunk_size) {
           j,
           n,
           reach_start,
-          reach_end);
+          reach_end,
+          &deltas);
 
       i += next_chunk_start.x_;
       j += next_chunk_start.y_;
-      progress.Set(i);
+      progress += next_chunk_start.x_;
+    }
+  });
+
+  for (auto&& window : windows) {
+    SaveDeltas(window.key_ref_, window.deltas_);
+    window.deltas_ = {};
+  }
+}
+
+/**
+ * Find anchors splitting ref and sv into windows, which can be aligned apart.
+ * An anchor is an ANCHOR_SIZE-mer of ref without 'N', taken about every
+ * ANCHOR_INTERVAL bases, which occurs only once in ref around it and once in
+ * sv around where the previous anchor leads to, and whose flanks match too.
+ * Thus both sides of an anchor are very likely the same locus, and an
+ * alignment would go through it.
+ * The first and last anchors are the starts and ends of both sequences.
+ */
+vector<Point> Dna::FindAnchors(const Sequence& ref, const Sequence& sv) {
+  const size_t max_tries = 16;
+  auto size = Config::ANCHOR_SIZE;
+  auto shift = Config::ANCHOR_MAX_SHIFT;
+  vector<Point> anchors{{0, 0}};
+
+  // Return the only position in value[start, end) matching ref at ref_pos,
+  // or end if there is none or more than one.
+  auto find = [&](const Sequence& value,
+                  size_t start,
+                  size_t end,
+                  size_t ref_pos) {
+    auto pos = end;
+    auto last = min(end, value.size() - min(value.size(), size - 1));
+    for (auto i = start; i < last; ++i) {
+      if (ref.Match(ref_pos, value, i, size, false) < size) continue;
+      if (value.HasUnknown(i, i + size)) continue;
+      if (pos != end) return end;
+      pos = i;
+    }
+    return pos;
+  };
+
+  for (auto ref_start = Config::ANCHOR_INTERVAL;
+       Config::ANCHOR_INTERVAL && ref_start + size < ref.size();
+       ref_start += Config::ANCHOR_INTERVAL) {
+    const auto& prev = anchors.back();
+    for (size_t k = 0; k < max_tries; ++k) {
+      auto ref_pos = ref_start + k * size;
+      if (ref_pos + size > ref.size()) break;
+      if (ref.HasUnknown(ref_pos, ref_pos + size)) continue;
+
+      auto ref_end = min(ref_pos + shift, ref.size());
+      auto ref_lo = max(ref_pos - min(ref_pos, shift), prev.x_ + 1ul);
+      if (find(ref, ref_lo, ref_end, ref_pos) != ref_pos) continue;
+
+      auto sv_mid = prev.y_ + (ref_pos - prev.x_);
+      auto sv_lo = max(sv_mid - min(sv_mid, shift), prev.y_ + 1ul);
+      auto sv_hi = min(sv_mid + shift, sv.size());
+      if (sv_lo >= sv_hi) continue;
+      auto sv_pos = find(sv, sv_lo, sv_hi, ref_pos);
+      if (sv_pos == sv_hi) continue;
+
+      // Keep anchors off the breakpoints, which the alignment should place.
+      if (ref_pos < size || sv_pos < size) continue;
+      auto flank_len = ref.Match(ref_pos - size, sv, sv_pos - size, size * 3);
+      if (flank_len < size * 3) continue;
+
+      anchors.emplace_back(ref_pos, sv_pos);
+      break;
     }
   }
+
+  anchors.emplace_back(ref.size(), sv.size());
+  return anchors;
 }
 
+/**
+ * Align each read to the chromosome it overlaps first, and call deltas from
+ * these alignments. Alignments don't depend on each other, so they run on all
+ * threads at once, each into its own buffer. Buffers are then replayed in the
+ * order of overlaps, which gives the same deltas as aligning reads one by one.
+ * Chromosomes are replayed concurrently, as their deltas never meet.
+ */
 void Dna::FindDeltasFromSegments() {
-  for (const auto& [key_ref, value_ref] : data_) {
-    const auto& entries = overlaps_.data_.at(key_ref);
-    unordered_set<string> used_segs;
-    Progress progress{
-        "Dna::FindDeltasFromSegments " + key_ref,
-        entries.size(),
-        100,
-    };
+  struct Alignment {
+    KeyId key_ref_;
+    const Minimizer* minimizer_p_;
+    ChunkDeltas deltas_;
+  };
 
-    for (const auto& minimizer : entries) {
-      const auto& [range_ref, key_seg, range_seg] = minimizer;
-      if (used_segs.count(key_seg)) {
-        ++progress;
-        continue;
+  // Alignments of chromosome i are from alignment_starts[i] until
+  // alignment_starts[i + 1].
+  vector<KeyId> key_refs;
+  vector<Alignment> alignments;
+  vector<size_t> alignment_starts;
+  for (const auto& [key_ref, value_ref] : data_) {
+    unordered_set<KeyId> used_segs;
+    key_refs.push_back(key_ref);
+    alignment_starts.push_back(alignments.size());
+    for (const auto& minimizer : overlaps_.data_.at(key_ref)) {
+      if (used_segs.insert(minimizer.key_seg_).second) {
+        alignments.push_back({key_ref, &minimizer, {}});
       }
-      used_segs.insert(key_seg);
+    }
 
-      const auto& value_seg = *(range_seg.value_p_);
+    // Chromosomes and their indexes must exist before they are replayed
+    // concurrently.
+    ins_deltas_.Reserve(key_ref);
+    del_deltas_.Reserve(key_ref);
+  }
+  alignment_starts.push_back(alignments.size());
 
-      Logger::Debug(
-          "Dna::FindDeltasFromSegments",
-          range_ref.Stringify(key_ref) + " " + range_seg.Stringify(key_seg));
+  Progress progress{
+      "Dna::FindDeltasFromSegments",
+      alignments.size(),
+      100,
+  };
 
-      Logger::Trace("", "REF: \t" + range_ref.Head());
-      Logger::Trace("", "SEG: \t" + range_seg.Head());
+  ParallelFor(alignments.size(), [&](size_t i) {
+    auto&& [key_ref, minimizer_p, deltas] = alignments[i];
+    const auto& [range_ref, key_seg, range_seg] = *minimizer_p;
+    const auto& name_ref = SequenceKey::Name(key_ref);
 
-      if (!Verify(range_ref, range_seg)) {
-        Logger::Warn(
-            "Dna::FindDeltasFromSegments",
-            key_ref + " " + key_seg + " minimizer not matched");
-      }
+    Logger::Debug(
+        "Dna::FindDeltasFromSegments",
+        minimizer_p->Stringify(key_ref));
 
-      FindDeltasChunk(
-          key_ref,
-          value_ref,
-          range_ref.start_,
-          range_ref.size(),
-          key_seg,
-          value_seg,
-          range_seg.start_,
-          range_seg.size(),
-          true,
-          true);
-
-      auto merge = [](DnaDelta& deltas,
-                      const string& key_ref,
-                      const Minimizer& minimizer) {
-        const auto& [range_ref, key_seg, range_seg] = minimizer;
-        vector<Range> delta_ranges;
-
-        auto density = deltas.GetDensity(key_ref, range_ref, &delta_ranges);
-        if (density > Config::SIGNAL_RATE) {
-          for (const auto& delta_range : delta_ranges) {
-            auto range_ref_content = Range{
-                range_ref.start_ + Config::HASH_SIZE,
-                range_ref.end_ - Config::HASH_SIZE,
-                range_ref.value_p_,
-            };
-            if (range_ref_content.Contains(delta_range) &&
-                delta_range.size() <= Config::DELTA_ALLOW_LEN) {
-              deltas.Merge(key_ref, key_seg, delta_range);
-            }
-          }
+    Logger::Trace("", "REF: \t" + range_ref.Head());
+    Logger::Trace("", "SEG: \t" + range_seg.Head());
+
+    if (!Verify(range_ref, range_seg)) {
+      Logger::Warn(
+          "Dna::FindDeltasFromSegments",
+          name_ref + " " + SequenceKey::Name(key_seg) +
+              " minimizer not matched");
+    }
+
+    FindDeltasChunk(
+        key_ref,
+        data_.at(key_ref),
+        range_ref.start_,
+        range_ref.size(),
+        key_seg,
+        *(range_seg.value_p_),
+        range_seg.start_,
+        range_seg.size(),
+        true,
+        true,
+        &deltas);
+    ++progress;
+  });
+
+  auto merge = [](DnaDelta& deltas,
+                  KeyId key_ref,
+                  const Minimizer& minimizer) {
+    const auto& [range_ref, key_seg, range_seg] = minimizer;
+    vector<Range> delta_ranges;
+
+    auto density = deltas.GetDensity(key_ref, range_ref, &delta_ranges);
+    if (density > Config::SIGNAL_RATE) {
+      for (const auto& delta_range : delta_ranges) {
+        auto range_ref_content = Range{
+            range_ref.start_ + Config::HASH_SIZE,
+            range_ref.end_ - Config::HASH_SIZE,
+            range_ref.value_p_,
+        };
+        if (range_ref_content.Contains(delta_range) &&
+            delta_range.size() <= Config::DELTA_ALLOW_LEN) {
+          deltas.Merge(key_ref, key_seg, delta_range);
         }
-        deltas.Filter(key_ref, key_seg);
-      };
+      }
+    }
+    deltas.Filter(key_ref, key_seg);
+  };
+
+  ParallelFor(key_refs.size(), [&](size_t i) {
+    auto key_ref = key_refs[i];
+    for (auto j = alignment_starts[i]; j < alignment_starts[i + 1]; ++j) {
+      auto&& alignment = alignments[j];
+      SaveDeltas(key_ref, alignment.deltas_);
+      alignment.deltas_ = {};
 
-      merge(ins_deltas_, key_ref, minimizer);
-      merge(del_deltas_, key_ref, minimizer);
-      ++progress;
+      merge(ins_deltas_, key_ref, *alignment.minimizer_p_);
+      merge(del_deltas_, key_ref, *alignment.minimizer_p_);
     }
 
     ins_deltas_.Merge(key_ref);
     del_deltas_.Merge(key_ref);
+  });
+}
+
+/**
+ * Follow the snake from mid until box_end, and return the end point.
+ * Matched bases are compared 32 at a time on the packed sequences, and 'N'
+ * matches any base. A mismatch is allowed while the error score does not
+ * exceed ERROR_MAX_SCORE, and each match reduces the score by MYERS_PENALTY.
+ * A snake shorter than SNAKE_MIN_LEN is not used.
+ */
+inline Point Dna::Slide(
+    const Sequence& ref,
+    size_t ref_start,
+    const Sequence& sv,
+    size_t sv_start,
+    const Point& mid,
+    const Point& box_end,
+    bool check_unknown) {
+  auto end = mid;
+  auto error_len = 0;
+  auto error_score = 0.0;
+
+  while (end.x_ < box_end.x_ && end.y_ < box_end.y_) {
+    auto max_len = min(box_end.x_ - end.x_, box_end.y_ - end.y_);
+    int match_len = ref.Match(
+        ref_start + end.x_, sv, sv_start + end.y_, max_len, check_unknown);
+    end = {end.x_ + match_len, end.y_ + match_len};
+    for (auto i = 0; i < match_len && error_score; ++i) {
+      error_score = max(error_score - Config::MYERS_PENALTY, 0.0);
+      if (!error_score) error_len = 0;
+    }
+    if (match_len == max_len) break;
+
+    ++error_len, ++error_score;
+    if (error_score > Config::ERROR_MAX_SCORE) {
+      --error_len;
+      end = {end.x_ - error_len, end.y_ - error_len};
+      break;
+    }
+    ++end.x_, ++end.y_;
   }
+
+  auto snake = static_cast<size_t>(end.x_ - mid.x_);
+  return snake < Config::SNAKE_MIN_LEN ? mid : end;
 }
 
-// Myers' diff algorithm implementation
+// Align a chunk with Myers' diff algorithm, in linear space if configured.
+// Deltas are saved into deltas_p instead if given, so that chunks can be
+// aligned concurrently.
 Point Dna::FindDeltasChunk(
-    const string& key_ref,
-    const string& ref,
+    KeyId key_ref,
+    const Sequence& ref,
     size_t ref_start,
     size_t m,
-    const string& key_sv,
-    const string& sv,
+    KeyId key_sv,
+    const Sequence& sv,
     size_t sv_start,
     size_t n,
     bool reach_start,
-    bool reach_end) {
+    bool reach_end,
+    ChunkDeltas* deltas_p) {
+  if (Config::MYERS_LINEAR_SPACE) {
+    // Paths always start from the start point in linear space.
+    assert(reach_start);
+    return FindDeltasChunkLinear(
+        key_ref,
+        ref,
+        ref_start,
+        m,
+        key_sv,
+        sv,
+        sv_start,
+        n,
+        reach_end,
+        deltas_p);
+  }
+  return FindDeltasChunkQuadratic(
+      key_ref,
+      ref,
+      ref_start,
+      m,
+      key_sv,
+      sv,
+      sv_start,
+      n,
+      reach_start,
+      reach_end,
+      deltas_p);
+}
+
+// Myers' diff algorithm implementation.
+Point Dna::FindDeltasChunkQuadratic(
+    KeyId key_ref,
+    const Sequence& ref,
+    size_t ref_start,
+    size_t m,
+    KeyId key_sv,
+    const Sequence& sv,
+    size_t sv_start,
+    size_t n,
+    bool reach_start,
+    bool reach_end,
+    ChunkDeltas* deltas_p) {
   auto max_steps = m + n;
   auto padding = max_steps;
   /**
@@ -466,6 +1063,9 @@ Point Dna::FindDeltasChunk(
    * Finally, we have end_xs[k + m + n] = x.
    */
   auto end_xs = vector<int>((max_steps << 1) + 1, 0);
+  // Skip checking 'N' in snakes if there is none in both chunks.
+  auto check_unknown = ref.HasUnknown(ref_start, ref_start + m) ||
+                       sv.HasUnknown(sv_start, sv_start + n);
   // end_xss[step] stores end_xs at each step.
   auto end_xss = vector<vector<int>>{};
   auto solution_found = false;
@@ -502,28 +1102,8 @@ Point Dna::FindDeltasChunk(
       auto mid_x = direction == TOP ? start.x_ : start.x_ + 1;
       auto mid = Point(mid_x, mid_x - k);
 
-      auto end = mid;
-      auto snake = 0ul;
-      for (auto [error_len, error_score] = tuple{0, 0.0};
-           end.x_ < static_cast<int>(m) && end.y_ < static_cast<int>(n);
-           ++end.x_, ++end.y_, ++snake) {
-        auto ref_char = ref[ref_start + end.x_];
-        auto sv_char = sv[sv_start + end.y_];
-        if (ref_char != sv_char && ref_char != 'N' && sv_char != 'N') {
-          ++error_len, ++error_score;
-          if (error_score > Config::ERROR_MAX_SCORE) {
-            --error_len;
-            end = {end.x_ - error_len, end.y_ - error_len};
-            snake -= error_len;
-            break;
-          }
-        } else {
-          error_score = max(error_score - Config::MYERS_PENALTY, 0.0);
-          if (!error_score) error_len = 0ul;
-        }
-      }
-      if (snake < Config::SNAKE_MIN_LEN) end = mid;
-
+      auto end = Slide(
+          ref, ref_start, sv, sv_start, mid, Point(m, n), check_unknown);
       end_xs[k + padding] = end.x_;
 
       auto x_reach_end = end.x_ >= static_cast<int>(m);
@@ -571,25 +1151,31 @@ Point Dna::FindDeltasChunk(
     auto insert_delta = [&](const Point& start, const Point& end) {
       auto size = end.y_ - start.y_;
       if (!size) return;
-      ins_deltas_.Set(
-          key_ref,
-          {
-              {ref_start + start.x_, ref_start + start.x_ + size, &ref},
-              key_sv,
-              {sv_start + start.y_, sv_start + end.y_, &sv},
-          });
+      auto delta = Minimizer{
+          {ref_start + start.x_, ref_start + start.x_ + size, &ref},
+          key_sv,
+          {sv_start + start.y_, sv_start + end.y_, &sv},
+      };
+      if (deltas_p) {
+        deltas_p->ins_.emplace_back(move(delta));
+      } else {
+        ins_deltas_.Set(key_ref, delta);
+      }
     };
 
     auto delete_delta = [&](const Point& start, const Point& end) {
       auto size = end.x_ - start.x_;
       if (!size) return;
-      del_deltas_.Set(
-          key_ref,
-          {
-              {ref_start + start.x_, ref_start + end.x_, &ref},
-              key_sv,
-              {ref_start + start.x_, ref_start + end.x_, &ref},
-          });
+      auto delta = Minimizer{
+          {ref_start + start.x_, ref_start + end.x_, &ref},
+          key_sv,
+          {ref_start + start.x_, ref_start + end.x_, &ref},
+      };
+      if (deltas_p) {
+        deltas_p->del_.emplace_back(move(delta));
+      } else {
+        del_deltas_.Set(key_ref, delta);
+      }
     };
 
     // If we meet a snake or the direction is changed, we store previous deltas.
@@ -631,11 +1217,263 @@ Point Dna::FindDeltasChunk(
   return next_chunk_start;
 }
 
-void Dna::FilterDeltas(const string& key_ref, const string& key_seg) {
+/**
+ * Linear-space variant of Myers' diff algorithm.
+ * Instead of saving end_xs at each step for backtracking, each k-line only
+ * remembers the edit where its path crosses the middle anti-diagonal of the
+ * current box. Once the end point is reached, this edit splits the box into
+ * two smaller boxes, which are solved in the same way (Hirschberg-style).
+ * Thus we only use O(m + n) memory, at the cost of O(log(m + n)) more passes.
+ */
+Point Dna::FindDeltasChunkLinear(
+    KeyId key_ref,
+    const Sequence& ref,
+    size_t ref_start,
+    size_t m,
+    KeyId key_sv,
+    const Sequence& sv,
+    size_t sv_start,
+    size_t n,
+    bool reach_end,
+    ChunkDeltas* deltas_p) {
+  // An edit from start to end. TOP_LEFT means a box to be solved instead.
+  struct Edit {
+    Point start_;
+    Point end_;
+    Direction direction_ = TOP_LEFT;
+  };
+
+  auto check_unknown = ref.HasUnknown(ref_start, ref_start + m) ||
+                       sv.HasUnknown(sv_start, sv_start + n);
+  auto slide = [&](const Point& mid, const Point& box_end) {
+    return Slide(ref, ref_start, sv, sv_start, mid, box_end, check_unknown);
+  };
+
+  /**
+   * Paths are kept in a band of k-lines, i.e. diagonals (x - y), from band_lo
+   * to band_hi. When the end point is known, the band covers the k-lines from
+   * the start to the end, widened by band_width on both sides. Otherwise, it
+   * covers the whole box.
+   */
+  int x_end = m, y_end = n;
+  auto band_width = reach_end ? static_cast<int>(Config::MYERS_BAND_WIDTH) : 0;
+  auto band_lo = -y_end, band_hi = x_end;
+  auto set_band = [&]() {
+    if (!band_width) return;
+    band_lo = max(min(0, x_end - y_end) - band_width, -y_end);
+    band_hi = min(max(0, x_end - y_end) + band_width, x_end);
+  };
+  set_band();
+
+  /**
+   * Run the forward pass of Myers' algorithm inside the box, and return the
+   * end point. Here k is relative to box_start, and all paths are kept inside
+   * the box and the band. If mid_edit_p is given, it receives an edit on the
+   * found path, which is used to split the box.
+   */
+  auto search = [&](const Point& box_start,
+                    const Point& box_end,
+                    bool reach_end,
+                    Edit* mid_edit_p) {
+    auto width = box_end.x_ - box_start.x_;
+    auto height = box_end.y_ - box_start.y_;
+    auto half = (width + height) >> 1;
+    // The band and the box in k-lines relative to box_start.
+    auto box_k = box_start.x_ - box_start.y_;
+    auto k_lo = max(band_lo - box_k, -height);
+    auto k_hi = min(band_hi - box_k, width);
+    auto padding = -k_lo;
+
+    auto terminate = [&](const Point& end) {
+      auto x_reach_end = end.x_ >= box_end.x_;
+      auto y_reach_end = end.y_ >= box_end.y_;
+      return reach_end ? x_reach_end && y_reach_end
+                       : x_reach_end || y_reach_end;
+    };
+
+    auto end = slide(box_start, box_end);
+    if (terminate(end)) return end;
+
+    // end_xs[k - k_lo] stores (x - box_start.x_), or -1 if unreachable.
+    auto end_xs = vector<int>(k_hi - k_lo + 1, -1);
+    // mid_edits[k - k_lo] stores the edit crossing the middle anti-diagonal.
+    auto mid_edits = vector<Edit>(k_hi - k_lo + 1);
+    end_xs[padding] = end.x_ - box_start.x_;
+
+    for (auto step = 1; step <= width + height; ++step) {
+      // Clamp k-lines to the band, keeping the same parity as step.
+      auto k_start = max(-step, k_lo);
+      if ((k_start + step) & 1) ++k_start;
+
+      for (auto k = k_start; k <= min(step, k_hi); k += 2) {
+        auto top_x =
+            k + 1 <= min(step - 1, k_hi) ? end_xs[k + 1 + padding] : -1;
+        auto left_x =
+            k - 1 >= max(1 - step, k_lo) ? end_xs[k - 1 + padding] : -1;
+        if (top_x < 0 && left_x < 0) {
+          end_xs[k + padding] = -1;
+          continue;
+        }
+
+        auto direction = top_x > left_x ? TOP : LEFT;
+        auto prev_k = direction == TOP ? k + 1 : k - 1;
+        auto start_x = direction == TOP ? top_x : left_x;
+        auto start = Point(
+            box_start.x_ + start_x, box_start.y_ + start_x - prev_k);
+
+        auto mid_x = direction == TOP ? start_x : start_x + 1;
+        auto mid = Point(box_start.x_ + mid_x, box_start.y_ + mid_x - k);
+        if (mid.x_ > box_end.x_ || mid.y_ > box_end.y_) {
+          end_xs[k + padding] = -1;
+          continue;
+        }
+
+        end = slide(mid, box_end);
+        end_xs[k + padding] = end.x_ - box_start.x_;
+
+        auto& mid_edit = mid_edits[k + padding];
+        mid_edit = mid_edits[prev_k + padding];
+        if (mid_edit.direction_ == TOP_LEFT && mid_x + mid_x - k >= half) {
+          mid_edit = {start, mid, direction};
+        }
+
+        if (terminate(end)) {
+          if (mid_edit_p) {
+            *mid_edit_p = mid_edit.direction_ == TOP_LEFT
+                              ? Edit{start, mid, direction}
+                              : mid_edit;
+          }
+          return end;
+        }
+      }
+    }
+
+    assert(false);
+    return box_end;
+  };
+
+  // Edits in the forward order, where consecutive edits are combined.
+  vector<Edit> edits;
+  auto save_edit = [&edits](const Edit& edit) {
+    if (edits.size() && edits.back().direction_ == edit.direction_ &&
+        edits.back().end_ == edit.start_) {
+      edits.back().end_ = edit.end_;
+    } else {
+      edits.emplace_back(edit);
+    }
+  };
+
+  /**
+   * A path of cost edits strays from the k-lines between the start and the end
+   * by at most (cost - |x_end - y_end|) / 2. So if the path found in the band
+   * would fit in a band of this width, no path outside could be shorter.
+   */
+  auto path_width = [&]() {
+    auto cost = 0;
+    for (const auto& [start, end, direction] : edits) {
+      cost += end.x_ - start.x_ + end.y_ - start.y_;
+    }
+    return (cost - abs(x_end - y_end) + 1) / 2;
+  };
+
+  Point next_chunk_start;
+  for (;;) {
+    Edit mid_edit;
+    next_chunk_start = search({}, Point(m, n), reach_end, &mid_edit);
+
+    // Solve boxes in order with a stack, in place of recursion.
+    vector<Edit> tasks;
+    if (mid_edit.direction_ != TOP_LEFT) {
+      tasks.push_back({mid_edit.end_, next_chunk_start});
+      tasks.push_back(mid_edit);
+      tasks.push_back({{}, mid_edit.start_});
+    }
+
+    while (tasks.size()) {
+      auto task = tasks.back();
+      tasks.pop_back();
+      const auto& [box_start, box_end, direction] = task;
+
+      if (direction != TOP_LEFT) {
+        save_edit(task);
+      } else if (box_start.x_ == box_end.x_ && box_start.y_ < box_end.y_) {
+        save_edit({box_start, box_end, TOP});
+      } else if (box_start.y_ == box_end.y_ && box_start.x_ < box_end.x_) {
+        save_edit({box_start, box_end, LEFT});
+      } else if (box_start != box_end) {
+        Edit box_mid_edit;
+        search(box_start, box_end, true, &box_mid_edit);
+        if (box_mid_edit.direction_ == TOP_LEFT) continue;
+        tasks.push_back({box_mid_edit.end_, box_end});
+        tasks.push_back(box_mid_edit);
+        tasks.push_back({box_start, box_mid_edit.start_});
+      }
+    }
+
+    auto width = path_width();
+    if (width <= band_width) break;
+    if (band_lo == -y_end && band_hi == x_end) break;
+    Logger::Trace(
+        "Dna::FindDeltasChunkLinear",
+        "Band width " + to_string(band_width) + " -> " + to_string(width));
+    edits.clear();
+    band_width = width;
+    set_band();
+  }
+
+  auto insert_delta = [&](const Point& start, const Point& end) {
+    auto size = end.y_ - start.y_;
+    if (!size) return;
+    auto delta = Minimizer{
+        {ref_start + start.x_, ref_start + start.x_ + size, &ref},
+        key_sv,
+        {sv_start + start.y_, sv_start + end.y_, &sv},
+    };
+    if (deltas_p) {
+      deltas_p->ins_.emplace_back(move(delta));
+    } else {
+      ins_deltas_.Set(key_ref, delta);
+    }
+  };
+
+  auto delete_delta = [&](const Point& start, const Point& end) {
+    auto size = end.x_ - start.x_;
+    if (!size) return;
+    auto delta = Minimizer{
+        {ref_start + start.x_, ref_start + end.x_, &ref},
+        key_sv,
+        {ref_start + start.x_, ref_start + end.x_, &ref},
+    };
+    if (deltas_p) {
+      deltas_p->del_.emplace_back(move(delta));
+    } else {
+      del_deltas_.Set(key_ref, delta);
+    }
+  };
+
+  // Save deltas from the end to the start, as FindDeltasChunk does.
+  for (auto edit_i = edits.rbegin(); edit_i < edits.rend(); ++edit_i) {
+    if (edit_i->direction_ == TOP) {
+      insert_delta(edit_i->start_, edit_i->end_);
+    } else {
+      delete_delta(edit_i->start_, edit_i->end_);
+    }
+  }
+
+  return next_chunk_start;
+}
+
+// Save deltas found by FindDeltasChunk, as if they were not buffered.
+void Dna::SaveDeltas(KeyId key_ref, const ChunkDeltas& deltas) {
+  for (const auto& delta : deltas.ins_) ins_deltas_.Set(key_ref, delta);
+  for (const auto& delta : deltas.del_) del_deltas_.Set(key_ref, delta);
+}
+
+void Dna::FilterDeltas(KeyId key_ref, KeyId key_seg) {
   ins_deltas_.Filter(key_ref, key_seg);
   del_deltas_.Filter(key_ref, key_seg);
 
-  if (key_ref.empty()) {
+  if (key_ref == SequenceKey::NONE) {
     Logger::Info("Dna::FilterDeltas", "Done");
   }
 }
@@ -646,8 +1484,11 @@ void Dna::FindDupDeltas() {
       auto&& [range_ref, key_seg, range_seg] = *delta_i;
       auto size = range_ref.size();
       auto cur_start = range_ref.start_;
+      if (cur_start < size) {
+        ++delta_i;
+        continue;
+      }
       auto prev_start = cur_start - size;
-      if (prev_start < 0) continue;
 
       auto cur_value = range_seg.get();
       auto prev_value = range_ref.value_p_->substr(prev_start, size);
@@ -670,140 +1511,176 @@ void Dna::FindDupDeltas() {
   Logger::Info("Dna::FindDupDeltas", "Done");
 }
 
-string Dna::Transform(const string& chain, Mode mode) {
-  const unordered_map<char, char> dna_base_pair{
-      {'A', 'T'},
-      {'T', 'A'},
-      {'C', 'G'},
-      {'G', 'C'},
-      {'N', 'N'},
-  };
-
-  string output_chain;
-
-  switch (mode) {
-    case REVERSE:
-      for (auto i = chain.rbegin(); i < chain.rend(); ++i) {
-        output_chain += *i;
-      }
-      break;
-    case COMPLEMENT:
-      for (auto i = chain.begin(); i < chain.end(); ++i) {
-        output_chain += dna_base_pair.at(*i);
-      }
-      break;
-    case REVR_COMP:
-      for (auto i = chain.rbegin(); i < chain.rend(); ++i) {
-        output_chain += dna_base_pair.at(*i);
-      }
-      break;
-    case NORMAL:
-    default:
-      output_chain = chain;
-      break;
-  }
-  return output_chain;
-}
-
+/**
+ * Pair each INS with the first DEL of the same size at the same place, whose
+ * ref is the reverse complement of the inserted segment. Their sizes differ,
+ * and they lie apart, by at most GAP_MAX_DIFF, which bounds where such a DEL
+ * starts. So DELs are sorted by their start, and only those starting in range
+ * are compared.
+ */
 void Dna::FindInvDeltas() {
   for (auto&& [key_ref, deltas_ins] : ins_deltas_.data_) {
-    for (auto delta_i = deltas_ins.begin(); delta_i < deltas_ins.end();) {
-      auto&& [range_ref_i, key_seg_i, range_seg_i] = *delta_i;
-      auto erased = false;
-
-      if (del_deltas_.data_.count(key_ref)) {
-        auto& deltas_del = del_deltas_.data_[key_ref];
-
-        for (auto delta_j = deltas_del.begin(); delta_j < deltas_del.end();
-             ++delta_j) {
-          auto&& [range_ref_j, key_seg_j, range_seg_j] = *delta_j;
-
-          if (FuzzyCompare(range_ref_i, range_ref_j)) {
-            // auto size = range_ref_i.size();
-            // range_ref_i.start_ = range_ref_j.start_;
-            // range_ref_i.end_ = range_ref_j.start_ + size;
-
-            if (FuzzyCompare(
-                    range_seg_i.get(),
-                    Transform(range_seg_j.get(), REVR_COMP))) {
-              inv_deltas_.Set(key_ref, *delta_j);
-              delta_i = deltas_ins.erase(delta_i);
-              delta_j = deltas_del.erase(delta_j);
-              erased = true;
-              break;
-            }
-          }
+    auto deltas_del_i = del_deltas_.data_.find(key_ref);
+    if (deltas_del_i == del_deltas_.data_.end()) continue;
+    auto& deltas_del = deltas_del_i->second;
+
+    vector<pair<size_t, size_t>> starts;
+    for (size_t j = 0; j < deltas_del.size(); ++j) {
+      starts.emplace_back(deltas_del[j].range_ref_.start_, j);
+    }
+    sort(starts.begin(), starts.end());
+
+    vector<bool> ins_removed(deltas_ins.size(), false);
+    vector<bool> del_removed(deltas_del.size(), false);
+    vector<size_t> candidates;
+    for (size_t i = 0; i < deltas_ins.size(); ++i) {
+      const auto& [range_ref_i, key_seg_i, range_seg_i] = deltas_ins[i];
+      auto max_len = range_ref_i.size() + (Config::GAP_MAX_DIFF << 1);
+      auto min_start = range_ref_i.start_ - min(range_ref_i.start_, max_len);
+      auto max_start = range_ref_i.end_ + Config::GAP_MAX_DIFF;
+
+      candidates.clear();
+      auto start_i =
+          lower_bound(starts.begin(), starts.end(), pair{min_start, 0ul});
+      for (; start_i < starts.end() && start_i->first <= max_start; ++start_i) {
+        if (!del_removed[start_i->second]) {
+          candidates.push_back(start_i->second);
+        }
+      }
+      sort(candidates.begin(), candidates.end());
+
+      for (auto j : candidates) {
+        const auto& [range_ref_j, key_seg_j, range_seg_j] = deltas_del[j];
+        if (FuzzyCompare(range_ref_i, range_ref_j) &&
+            FuzzyCompare(range_seg_i.get(), range_seg_j.get(REVR_COMP))) {
+          inv_deltas_.Set(key_ref, deltas_del[j]);
+          ins_removed[i] = del_removed[j] = true;
+          break;
         }
       }
-
-      if (!erased) ++delta_i;
     }
+
+    EraseRemoved(&deltas_ins, ins_removed);
+    EraseRemoved(&deltas_del, del_removed);
   }
 
   Logger::Info("Dna::FindInvDeltas", "Done");
 }
 
+/**
+ * A MinHash sketch of chain: the SKETCH_SIZE smallest distinct hashes of its
+ * SKETCH_HASH_SIZE-mers without 'N'. K-mers are scrambled first, so that the
+ * smallest hashes are not all made of 'A'.
+ */
+vector<uint64_t> Dna::Sketch(const string& chain) {
+  assert(Config::SKETCH_HASH_SIZE > 0 && Config::SKETCH_HASH_SIZE < 32);
+  auto mask = ~(UINT64_MAX << (Config::SKETCH_HASH_SIZE << 1));
+  vector<uint64_t> sketch;
+  uint64_t hash = 0;
+  size_t known_len = 0;
+
+  for (auto c : chain) {
+    hash = ((hash << 2) & mask) | BASE_CODES[static_cast<uint8_t>(c)];
+    known_len = c == 'N' ? 0 : known_len + 1;
+    if (known_len < Config::SKETCH_HASH_SIZE) continue;
+    auto scrambled = hash * 0x9e3779b97f4a7c15ull;
+    sketch.push_back(scrambled ^ (scrambled >> 29));
+  }
+
+  sort(sketch.begin(), sketch.end());
+  sketch.erase(unique(sketch.begin(), sketch.end()), sketch.end());
+  if (sketch.size() > Config::SKETCH_SIZE) sketch.resize(Config::SKETCH_SIZE);
+  return sketch;
+}
+
+/**
+ * Pair each INS with a DEL of about the same size anywhere, whose ref is the
+ * inserted segment. Candidates are the DELs sharing enough of the sketch of
+ * the INS, which are compared from the most similar sketch on.
+ */
 void Dna::FindTraDeltas() {
-  vector<tuple<string, Minimizer>> ins_cache;
-  vector<tuple<string, Minimizer>> del_cache;
-
-  for (auto&& [key, deltas_ins] : ins_deltas_.data_) {
-    for (auto delta_i = deltas_ins.begin(); delta_i < deltas_ins.end();) {
-      auto&& [range_ref_i, key_seg_i, range_seg_i] = *delta_i;
-      auto erased = false;
-
-      if (del_deltas_.data_.count(key)) {
-        auto& deltas_del = del_deltas_.data_[key];
-
-        for (auto delta_j = deltas_del.begin(); delta_j < deltas_del.end();
-             ++delta_j) {
-          auto&& [range_ref_j, key_seg_j, range_seg_j] = *delta_j;
-
-          if (FuzzyCompare(range_ref_i.size(), range_ref_j.size())) {
-            ins_cache.emplace_back(key, *delta_i);
-            del_cache.emplace_back(key, *delta_j);
-            delta_i = deltas_ins.erase(delta_i);
-            delta_j = deltas_del.erase(delta_j);
-            erased = true;
-            break;
-          }
-        }
-      }
+  struct Entry {
+    KeyId key_;
+    size_t pos_;
+    vector<uint64_t> sketch_;
+  };
 
-      if (!erased) ++delta_i;
+  auto collect = [](DnaDelta* deltas_p, vector<Entry>* entries_p) {
+    auto&& entries = *entries_p;
+    for (const auto& [key, deltas] : deltas_p->data_) {
+      for (size_t pos = 0; pos < deltas.size(); ++pos) {
+        entries.push_back({key, pos, {}});
+      }
     }
-  }
+    ParallelFor(entries.size(), [&](size_t i) {
+      auto&& [key, pos, sketch] = entries[i];
+      sketch = Sketch(deltas_p->data_.at(key)[pos].range_seg_.get());
+    });
+  };
 
-  for (auto entry_i = ins_cache.begin(); entry_i < ins_cache.end();) {
-    auto [key_ins, delta_ins] = *entry_i;
-    auto&& [range_ref_i, key_seg_i, range_seg_i] = delta_ins;
-    auto erased = false;
+  vector<Entry> ins_entries, del_entries;
+  collect(&ins_deltas_, &ins_entries);
+  collect(&del_deltas_, &del_entries);
 
-    for (auto entry_j = del_cache.begin(); entry_j < del_cache.end();
-         ++entry_j) {
-      auto [key_del, delta_del] = *entry_j;
-      auto&& [range_ref_j, key_seg_j, range_seg_j] = delta_del;
+  unordered_map<uint64_t, vector<size_t>> sketch_index;
+  for (size_t j = 0; j < del_entries.size(); ++j) {
+    for (auto hash : del_entries[j].sketch_) sketch_index[hash].push_back(j);
+  }
 
-      if (FuzzyCompare(range_seg_i.get(), range_seg_j.get())) {
+  unordered_map<KeyId, vector<bool>> ins_removed, del_removed;
+  for (const auto& [key, deltas] : ins_deltas_.data_) {
+    ins_removed[key].resize(deltas.size());
+  }
+  for (const auto& [key, deltas] : del_deltas_.data_) {
+    del_removed[key].resize(deltas.size());
+  }
+
+  vector<size_t> shared(del_entries.size());
+  vector<size_t> candidates;
+  for (const auto& [key_ins, pos_i, sketch_i] : ins_entries) {
+    const auto& [range_ref_i, key_seg_i, range_seg_i] =
+        ins_deltas_.data_[key_ins][pos_i];
+
+    candidates.clear();
+    for (auto hash : sketch_i) {
+      auto index_i = sketch_index.find(hash);
+      if (index_i == sketch_index.end()) continue;
+      for (auto j : index_i->second) {
+        if (++shared[j] == Config::SKETCH_MIN_SHARED) candidates.push_back(j);
+      }
+    }
+    stable_sort(candidates.begin(), candidates.end(), [&](auto j1, auto j2) {
+      return shared[j1] > shared[j2];
+    });
+
+    auto value_i = range_seg_i.get();
+    for (auto j : candidates) {
+      const auto& [key_del, pos_j, sketch_j] = del_entries[j];
+      const auto& [range_ref_j, key_seg_j, range_seg_j] =
+          del_deltas_.data_[key_del][pos_j];
+      if (del_removed[key_del][pos_j] ||
+          !FuzzyCompare(range_ref_i.size(), range_ref_j.size())) {
+        continue;
+      }
+      if (FuzzyCompare(value_i, range_seg_j.get())) {
         tra_deltas_.Set(key_ins, range_ref_i, key_del, range_ref_j);
-        entry_i = ins_cache.erase(entry_i);
-        entry_j = del_cache.erase(entry_j);
-        erased = true;
+        ins_removed[key_ins][pos_i] = del_removed[key_del][pos_j] = true;
         break;
       }
     }
 
-    if (!erased) ++entry_i;
+    for (auto hash : sketch_i) {
+      auto index_i = sketch_index.find(hash);
+      if (index_i == sketch_index.end()) continue;
+      for (auto j : index_i->second) shared[j] = 0;
+    }
   }
 
-  for (const auto& [key, delta] : ins_cache) {
-    auto& deltas_ins = ins_deltas_.data_[key];
-    deltas_ins.emplace_back(delta);
+  for (auto&& [key, deltas] : ins_deltas_.data_) {
+    EraseRemoved(&deltas, ins_removed[key]);
   }
-
-  for (const auto& [key, delta] : del_cache) {
-    auto& deltas_del = del_deltas_.data_[key];
-    deltas_del.emplace_back(delta);
+  for (auto&& [key, deltas] : del_deltas_.data_) {
+    EraseRemoved(&deltas, del_removed[key]);
   }
 
   Logger::Info("Dna::FindTraDeltas", "Done");
@@ -813,7 +1690,7 @@ void Dna::ProcessDeltas() {
   FilterDeltas();
   FindDupDeltas();
   FindInvDeltas();
-  // FindTraDeltas();
+  FindTraDeltas();
 }
 
 bool Dna::PrintDeltas(const string& filename) const {
@@ -1,6 +1,8 @@
 #ifndef SRC_COMMON_DNA_H_
 #define SRC_COMMON_DNA_H_
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -8,9 +10,14 @@
 #include <vector>
 
 #include "dna_delta.h"
+#include "dna_index.h"
 #include "dna_overlap.h"
+#include "minimizer.h"
 #include "point.h"
+#include "progress.h"
 #include "range.h"
+#include "sequence.h"
+#include "sequence_key.h"
 
 class Dna {
  public:
@@ -26,7 +33,10 @@ class Dna {
   bool PrintIndex(const std::string& filename) const;
 
   bool ImportOverlaps(Dna* segments_p, const std::string& filename);
+  void ImportOverlaps(Dna* segments_p);
   bool FindOverlaps(const Dna& ref);
+  bool FindOverlaps(
+      const Dna& ref, const std::string& filename, bool keep_reads = true);
   bool PrintOverlaps(const std::string& filename) const;
 
   void CreateSvChain(const Dna& ref, const Dna& segments);
@@ -34,7 +44,7 @@ class Dna {
   void FindDeltas(const Dna& sv, size_t chunk_size = 10000);
   void FindDeltasFromSegments();
   void FilterDeltas(
-      const std::string& key_ref = "", const std::string& key_seg = "");
+      KeyId key_ref = SequenceKey::NONE, KeyId key_seg = SequenceKey::NONE);
   void FindDupDeltas();
   void FindInvDeltas();
   void FindTraDeltas();
@@ -42,27 +52,87 @@ class Dna {
   bool PrintDeltas(const std::string& filename) const;
 
   friend class Test;
+  friend class Bench;
 
  protected:
+  bool ImportBinaryIndex(const std::string& filename);
+  static bool MapReads(
+      const Dna& ref,
+      const std::vector<std::pair<std::string, Sequence*>>& reads,
+      std::vector<DnaOverlap>* overlaps_p,
+      Progress* progress_p = nullptr);
+
   static uint64_t NextHash(uint64_t hash, char next_base);
-  static std::string Transform(const std::string& chain, Mode mode);
+  static void RollHashes(
+      const std::string& chain, std::vector<uint64_t>* hashes_p);
+  static void RollHashes(
+      const Sequence& value,
+      size_t start,
+      size_t end,
+      std::vector<uint64_t>* hashes_p);
+  static void RollModeHashes(
+      const std::string& chain, std::array<std::vector<uint64_t>, 4>* hashes_p);
+  static std::vector<std::pair<uint64_t, size_t>> FindMinimizers(
+      const Sequence& value);
+  // INS and DEL deltas of an alignment, in the order they are found.
+  struct ChunkDeltas {
+    std::vector<Minimizer> ins_;
+    std::vector<Minimizer> del_;
+  };
+
+  static std::vector<Point> FindAnchors(
+      const Sequence& ref, const Sequence& sv);
+  static std::vector<uint64_t> Sketch(const std::string& chain);
+  static Point Slide(
+      const Sequence& ref,
+      size_t ref_start,
+      const Sequence& sv,
+      size_t sv_start,
+      const Point& mid,
+      const Point& box_end,
+      bool check_unknown = true);
 
   Point FindDeltasChunk(
-      const std::string& key_ref,
-      const std::string& ref,
+      KeyId key_ref,
+      const Sequence& ref,
+      size_t ref_start,
+      size_t m,
+      KeyId key_sv,
+      const Sequence& sv,
+      size_t sv_start,
+      size_t n,
+      bool reach_start = true,
+      bool reach_end = false,
+      ChunkDeltas* deltas_p = nullptr);
+  Point FindDeltasChunkQuadratic(
+      KeyId key_ref,
+      const Sequence& ref,
       size_t ref_start,
       size_t m,
-      const std::string& key_sv,
-      const std::string& sv,
+      KeyId key_sv,
+      const Sequence& sv,
       size_t sv_start,
       size_t n,
       bool reach_start = true,
-      bool reach_end = false);
+      bool reach_end = false,
+      ChunkDeltas* deltas_p = nullptr);
+  Point FindDeltasChunkLinear(
+      KeyId key_ref,
+      const Sequence& ref,
+      size_t ref_start,
+      size_t m,
+      KeyId key_sv,
+      const Sequence& sv,
+      size_t sv_start,
+      size_t n,
+      bool reach_end = false,
+      ChunkDeltas* deltas_p = nullptr);
+  void SaveDeltas(KeyId key_ref, const ChunkDeltas& deltas);
 
  private:
-  std::unordered_map<std::string, std::string> data_;
+  std::unordered_map<KeyId, Sequence> data_;
 
-  std::unordered_multimap<uint64_t, std::pair<std::string, Range>> range_index_;
+  DnaIndex index_;
 
   DnaOverlap overlaps_;
 
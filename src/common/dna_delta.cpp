@@ -3,7 +3,6 @@
 #include <algorithm>
 #include <cassert>
 #include <fstream>
-#include <iterator>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -13,51 +12,63 @@
 #include "logger.h"
 #include "minimizer.h"
 #include "range.h"
+#include "sequence_key.h"
 #include "utils.h"
 
 using std::accumulate;
 using std::count;
-using std::fill;
+using std::find;
+using std::lower_bound;
 using std::max;
 using std::min;
 using std::move;
-using std::next;
 using std::ofstream;
 using std::pair;
-using std::prev;
+using std::sort;
 using std::string;
 using std::to_string;
+using std::unique;
 using std::vector;
 
 void DnaDelta::Print(ofstream& out_file) const {
   for (const auto& [key_ref, deltas] : data_) {
     for (const auto& [range_ref, key_seg, range_seg] : deltas) {
-      out_file << type_ << " " << range_ref.Stringify(key_ref) << "\n";
+      out_file << type_ << " "
+               << range_ref.Stringify(SequenceKey::Name(key_ref)) << "\n";
     }
   }
 }
 
-void DnaDelta::Set(const string& key, const Minimizer& value) {
-  auto& deltas = data_[key];
+void DnaDelta::Set(KeyId key, const Minimizer& value) {
+  Reserve(key);
+  auto& deltas = data_.at(key);
+  const auto& range_ref = value.range_ref_;
 
   auto delta_str = [&](const Minimizer& delta) {
-    return type_ + " " + delta.range_ref_.Stringify(key);
+    return type_ + " " + delta.range_ref_.Stringify(SequenceKey::Name(key));
   };
 
+  // Combine value with the latest delta overlapping it, if any.
   auto exist = [&](const Minimizer& delta) {
-    for (auto prev_i = deltas.rbegin(); prev_i < deltas.rend(); ++prev_i) {
-      // if (prev_i->key_seg_ != delta.key_seg_) break;
-      if (Combine(&*prev_i, &delta)) {
-        Logger::Trace("DnaDelta::Set", "Merged:  \t" + delta_str(*prev_i));
+    auto positions = Find(
+        key,
+        range_ref.start_ - min(range_ref.start_, Config::GAP_MIN_DIFF),
+        range_ref.end_ + Config::GAP_MIN_DIFF);
+    for (auto pos_i = positions.rbegin(); pos_i < positions.rend(); ++pos_i) {
+      if (Combine(key, &deltas[*pos_i], &delta)) {
+        AddToIndex(key, *pos_i);
+        Logger::Trace(
+            "DnaDelta::Set", "Merged:  \t" + delta_str(deltas[*pos_i]));
         return true;
       }
     }
     return false;
   };
 
-  if (value.range_ref_.size() > Config::DELTA_IGNORE_LEN) {
+  if (range_ref.size() > Config::DELTA_IGNORE_LEN) {
     if (deltas.empty() || !exist(value)) {
       deltas.emplace_back(value);
+      AddToIndex(key, deltas.size() - 1);
       Logger::Trace("DnaDelta::Set", "Saved:   \t" + delta_str(value));
     }
   } else {
@@ -65,94 +76,157 @@ void DnaDelta::Set(const string& key, const Minimizer& value) {
   }
 }
 
-void DnaDelta::Merge(
-    const string& key_ref, const string& key_seg, const Range& range) {
-  auto& deltas = data_[key_ref];
-  vector<Minimizer> merged_deltas;
+/**
+ * Combine each delta of key_seg within range with the first earlier delta it
+ * can be combined with, and drop the ones out of range. Combined deltas span
+ * at most DELTA_ALLOW_LEN, so a delta can only be combined with deltas which
+ * started within DELTA_ALLOW_LEN of it, however they have grown since. These
+ * are found by sorting the deltas by their start once, and searching them.
+ * Removed deltas are only marked until the end, so that positions stay valid,
+ * and then erased in one pass, along with their merged segments.
+ */
+void DnaDelta::Merge(KeyId key_ref, KeyId key_seg, const Range& range) {
+  Reserve(key_ref);
+  auto& deltas = data_.at(key_ref);
+  vector<bool> removed(deltas.size(), false);
+
+  vector<pair<size_t, size_t>> starts;
+  starts.reserve(deltas.size());
+  for (size_t pos = 0; pos < deltas.size(); ++pos) {
+    starts.emplace_back(deltas[pos].range_ref_.start_, pos);
+  }
+  sort(starts.begin(), starts.end());
+
+  vector<size_t> base_positions;
+  for (size_t pos = 0; pos < deltas.size(); ++pos) {
+    const auto& delta = deltas[pos];
+    if (key_seg != SequenceKey::NONE && delta.key_seg_ != key_seg) continue;
+    if (range && !range.Contains(delta.range_ref_)) {
+      removed[pos] = true;
+      continue;
+    }
 
-  for (const auto& delta : deltas) {
-    auto merged = false;
-    if (key_seg.empty() || delta.key_seg_ == key_seg) {
-      if (range && !range.Contains(delta.range_ref_)) {
-        continue;
-      }
-      for (auto&& merged_delta : merged_deltas) {
-        if (Combine(&merged_delta, &delta, false)) {
-          merged = true;
-          break;
-        }
+    // Earlier deltas only grow, and this one is still as it was saved.
+    const auto& range_ref = delta.range_ref_;
+    auto min_start =
+        range_ref.end_ - min(range_ref.end_, Config::DELTA_ALLOW_LEN);
+    auto max_start = range_ref.start_ + Config::DELTA_ALLOW_LEN;
+    base_positions.clear();
+    for (auto start_i = lower_bound(
+             starts.begin(), starts.end(), pair<size_t, size_t>{min_start, 0});
+         start_i < starts.end() && start_i->first <= max_start;
+         ++start_i) {
+      auto base_pos = start_i->second;
+      if (base_pos < pos && !removed[base_pos]) {
+        base_positions.push_back(base_pos);
       }
     }
-    if (!merged) {
-      merged_deltas.emplace_back(delta);
+    sort(base_positions.begin(), base_positions.end());
+
+    for (auto base_pos : base_positions) {
+      if (Combine(key_ref, &deltas[base_pos], &delta, false)) {
+        AddToIndex(key_ref, base_pos);
+        removed[pos] = true;
+        break;
+      }
     }
   }
 
-  deltas = merged_deltas;
+  size_t from = find(removed.begin(), removed.end(), true) - removed.begin();
+  auto end = from;
+  auto&& arena = arenas_.at(key_ref);
+  for (auto pos = from; pos < deltas.size(); ++pos) {
+    if (!removed[pos]) {
+      deltas[end++] = move(deltas[pos]);
+    } else if (deltas[pos].key_seg_ == SequenceKey::NONE) {
+      arena.Release(deltas[pos].range_seg_.value_p_);
+    }
+  }
+  if (end == deltas.size()) return;
+  deltas.resize(end);
+  Reindex(key_ref, from);
 }
 
-void DnaDelta::Filter(const string& key_ref, const string& key_seg) {
-  auto filter_ref = [&](vector<Minimizer>& deltas, const string& key_ref_i) {
+void DnaDelta::Filter(KeyId key_ref, KeyId key_seg) {
+  auto filter_ref = [&](vector<Minimizer>& deltas, KeyId key_ref_i) {
+    auto from = deltas.size();
     for (auto delta_i = deltas.end() - 1;
-         delta_i >= deltas.begin() &&
-         (delta_i->key_seg_ == key_seg || delta_i->key_seg_.empty());
+         delta_i >= deltas.begin() && (delta_i->key_seg_ == key_seg ||
+                                       delta_i->key_seg_ == SequenceKey::NONE);
          --delta_i) {
       auto&& [range_ref, key_seg_i, range_seg] = *delta_i;
       if (range_ref.size() < Config::DELTA_MIN_LEN ||
           range_ref.size() > Config::DELTA_MAX_LEN) {
-        if (key_seg_i.empty()) {
-          delete range_seg.value_p_;
+        if (key_seg_i == SequenceKey::NONE) {
+          arenas_.at(key_ref_i).Release(range_seg.value_p_);
         }
+        from = delta_i - deltas.begin();
         delta_i = deltas.erase(delta_i);
       } else {
         Logger::Debug(
             "DnaDelta::Filter",
-            "Saved:   \t" + type_ + " " + range_ref.Stringify(key_ref_i));
+            "Saved:   \t" + type_ + " " +
+                range_ref.Stringify(SequenceKey::Name(key_ref_i)));
       }
     }
+    Reindex(key_ref_i, from);
   };
 
-  if (key_ref.empty()) {
+  if (key_ref == SequenceKey::NONE) {
     for (auto&& [key_ref_i, deltas] : data_) {
       filter_ref(deltas, key_ref_i);
     }
   } else {
-    auto&& deltas = data_[key_ref];
+    Reserve(key_ref);
+    auto&& deltas = data_.at(key_ref);
     filter_ref(deltas, key_ref);
   }
 }
 
+/**
+ * Find the windows of range where most positions are covered by deltas. The
+ * coverage is computed in a buffer spanning the range and the deltas
+ * overlapping it only, which each thread reuses between calls.
+ */
 double DnaDelta::GetDensity(
-    const string& key, const Range& range, vector<Range>* delta_ranges_p) {
-  auto& deltas = data_[key];
-  auto& density = density_[key];
-
-  auto start = density.begin() + range.start_;
-  auto end = density.begin() + range.end_;
-
-  fill(
-      prev(start, min(range.start_, Config::DELTA_MAX_LEN)),
-      next(end, Config::DELTA_MAX_LEN),
-      0);
+    KeyId key, const Range& range, vector<Range>* delta_ranges_p) {
+  Reserve(key);
+  const auto& deltas = data_.at(key);
+  auto window_size = Config::DENSITY_WINDOW_SIZE;
 
+  vector<const Range*> delta_ranges;
   auto min_start = range.start_;
   auto max_end = range.end_;
-  for (const auto& delta : deltas) {
-    if (!StrictOverlap(delta.range_ref_, range)) continue;
-    const auto& delta_range = delta.range_ref_;
-
-    ++density[delta_range.start_];
-    --density[delta_range.end_];
+  auto positions = Find(
+      key,
+      range.start_ - min(range.start_, Config::GAP_MIN_DIFF),
+      range.end_ + Config::GAP_MIN_DIFF);
+  for (auto pos : positions) {
+    const auto& delta_range = deltas[pos].range_ref_;
+    if (!StrictOverlap(delta_range, range)) continue;
+    delta_ranges.push_back(&delta_range);
     min_start = min(min_start, delta_range.start_);
     max_end = max(max_end, delta_range.end_);
   }
 
-  for (auto i = min_start; i <= max_end; ++i) {
+  // density[i - offset] is for position i. Windows may reach window_size
+  // positions out of range on both sides.
+  static thread_local vector<int> density;
+  auto offset = min_start - min(min_start, window_size);
+  density.assign(max(max_end, range.end_ + window_size) - offset + 2, 0);
+  auto start = density.begin() + (range.start_ - offset);
+  auto end = density.begin() + (range.end_ - offset);
+
+  for (const auto* delta_range_p : delta_ranges) {
+    ++density[delta_range_p->start_ - offset];
+    --density[delta_range_p->end_ - offset];
+  }
+
+  for (auto i = min_start - offset; i <= max_end - offset; ++i) {
     density[i + 1] += density[i];
     density[i] = (density[i] > 0);
   }
 
-  auto window_size = Config::DENSITY_WINDOW_SIZE;
   auto sum = accumulate(start, start + window_size - 1, 0.0);
   auto max_density = sum / window_size;
   Range delta_range;
@@ -166,7 +240,7 @@ double DnaDelta::GetDensity(
       Logger::Warn("DnaDelta::GetDensity", to_string(cur_density) + " > 1");
     }
     if (cur_density >= Config::SIGNAL_RATE) {
-      auto cur_start = i - density.begin() - window_size + 1ul;
+      auto cur_start = i - density.begin() + offset - window_size + 1;
       if (!delta_range.start_) {
         delta_range.start_ = cur_start;
       }
@@ -183,13 +257,21 @@ double DnaDelta::GetDensity(
 
   Logger::Debug(
       "DnaDelta::GetDensity",
-      type_ + " " + range.Stringify(key) + " " + to_string(max_density));
+      type_ + " " + range.Stringify(SequenceKey::Name(key)) + " " +
+          to_string(max_density));
 
   return max_density;
 }
 
+void DnaDelta::Reserve(KeyId key) {
+  if (data_.count(key)) return;
+  data_[key];
+  index_[key];
+  arenas_[key];
+}
+
 bool DnaDelta::Combine(
-    Minimizer* base_p, const Minimizer* value_p, bool strict) const {
+    KeyId key, Minimizer* base_p, const Minimizer* value_p, bool strict) {
   auto&& [base_range_ref, base_key_seg, base_range_seg] = *base_p;
   const auto& [range_ref, key_seg, range_seg] = *value_p;
 
@@ -208,36 +290,37 @@ bool DnaDelta::Combine(
 
     *base_p = {new_ref, key_seg, new_seg};
   } else if (!base_range_ref.Contains(range_ref) || base_range_seg.unknown_) {
-    // Create a new string in heap.
-    auto new_value_seg_p = new string(new_ref.size(), 'N');
+    string new_value_seg(new_ref.size(), 'N');
 
-    auto fill_in = [new_value_seg_p](size_t start_pos, const Range& range) {
+    auto fill_in = [&new_value_seg](size_t start_pos, const Range& range) {
       auto value_seg = range.get();
       for (auto i = 0ul; i < range.size(); ++i) {
         auto j = start_pos + i;
-        if (j >= new_value_seg_p->size()) break;
+        if (j >= new_value_seg.size()) break;
         auto c = value_seg[i];
         if (c != 'N') {
           if (string("ATCG").find(c) == string::npos) {
             Logger::Warn("DnaDelta::Combine", "Invalid char: " + string(1, c));
           }
-          (*new_value_seg_p)[j] = value_seg[i];
+          new_value_seg[j] = value_seg[i];
         }
       }
     };
 
     fill_in(base_range_ref.start_ - new_ref.start_, base_range_seg);
     fill_in(range_ref.start_ - new_ref.start_, range_seg);
-    Logger::Trace("DnaDelta::Combine", "Created: " + *new_value_seg_p);
+    Logger::Trace("DnaDelta::Combine", "Created: " + new_value_seg);
 
-    // Delete the old created string.
-    if (base_key_seg.empty() && base_range_seg.value_p_) {
-      delete base_range_seg.value_p_;
+    // Replace the old merged segment, if any, in the arena of key.
+    auto&& arena = arenas_.at(key);
+    if (base_key_seg == SequenceKey::NONE) {
+      arena.Release(base_range_seg.value_p_);
     }
+    auto new_value_seg_p = arena.Create(new_value_seg);
 
     // Replace the original string.
-    auto n_count = count(new_value_seg_p->begin(), new_value_seg_p->end(), 'N');
-    auto unknown = n_count >= new_value_seg_p->size() * Config::UNKNOWN_RATE;
+    auto n_count = count(new_value_seg.begin(), new_value_seg.end(), 'N');
+    auto unknown = n_count >= new_value_seg.size() * Config::UNKNOWN_RATE;
     Range new_seg{
         0,
         new_value_seg_p->size(),
@@ -245,28 +328,85 @@ bool DnaDelta::Combine(
         NORMAL,
         unknown,
     };
-    *base_p = {new_ref, "", new_seg};
+    *base_p = {new_ref, SequenceKey::NONE, new_seg};
   }
   return true;
 }
 
+// Positions of the deltas of key covering any of [start, end], in order.
+vector<size_t> DnaDelta::Find(KeyId key, size_t start, size_t end) const {
+  vector<size_t> positions;
+  auto data_i = data_.find(key);
+  auto index_i = index_.find(key);
+  if (data_i == data_.end() || index_i == index_.end()) return positions;
+  const auto& deltas = data_i->second;
+  const auto& buckets = index_i->second.buckets_;
+
+  for (auto bucket = start / BUCKET_SIZE; bucket <= end / BUCKET_SIZE;
+       ++bucket) {
+    auto bucket_i = buckets.find(bucket);
+    if (bucket_i == buckets.end()) continue;
+    for (auto pos : bucket_i->second) {
+      if (pos >= deltas.size()) continue;
+      const auto& range_ref = deltas[pos].range_ref_;
+      if (range_ref.start_ <= end && range_ref.end_ >= start) {
+        positions.push_back(pos);
+      }
+    }
+  }
+
+  sort(positions.begin(), positions.end());
+  positions.erase(unique(positions.begin(), positions.end()), positions.end());
+  return positions;
+}
+
+// Index the delta at pos of key, after it is saved or grown.
+void DnaDelta::AddToIndex(KeyId key, size_t pos) {
+  auto&& index = index_.at(key);
+  Add(&index, data_.at(key)[pos], pos);
+  if (index.entry_count_ > (index.rebuilt_count_ << 1) + BUCKET_SIZE) {
+    Reindex(key);
+  }
+}
+
+// Index the deltas of key from position from, after they are moved.
+void DnaDelta::Reindex(KeyId key, size_t from) {
+  auto&& index = index_.at(key);
+  const auto& deltas = data_.at(key);
+  if (!from) index = {};
+  for (auto pos = from; pos < deltas.size(); ++pos) {
+    Add(&index, deltas[pos], pos);
+  }
+  if (!from) index.rebuilt_count_ = index.entry_count_;
+}
+
+void DnaDelta::Add(Index* index_p, const Minimizer& delta, size_t pos) {
+  auto&& index = *index_p;
+  const auto& range_ref = delta.range_ref_;
+  for (auto bucket = range_ref.start_ / BUCKET_SIZE;
+       bucket <= range_ref.end_ / BUCKET_SIZE;
+       ++bucket) {
+    index.buckets_[bucket].push_back(pos);
+    ++index.entry_count_;
+  }
+}
+
 void DnaMultiDelta::Print(ofstream& out_file) const {
   for (const auto& [key, ranges] : data_) {
     for (const auto& range : ranges) {
-      out_file << type_ << " " << range.first.Stringify(key.first) << " "
-               << range.second.Stringify(key.second) << "\n";
+      out_file << type_ << " "
+               << range.first.Stringify(SequenceKey::Name(key.first)) << " "
+               << range.second.Stringify(SequenceKey::Name(key.second))
+               << "\n";
     }
   }
 }
 
 void DnaMultiDelta::Set(
-    const string& key1,
-    const Range& range1,
-    const string& key2,
-    const Range& range2) {
-  auto save_range = [&](const string& key1,
+    KeyId key1, const Range& range1, KeyId key2, const Range& range2) {
+  auto save_range = [&](KeyId key1,
                         const Range& range1,
-                        const string& key2,
+                        KeyId key2,
                         const Range& range2) {
     auto& ranges = data_[{key1, key2}];
     auto range = pair{range1, range2};
@@ -280,8 +420,9 @@ void DnaMultiDelta::Set(
       ranges.emplace_back(range);
       Logger::Debug(
           "DnaDelta::Set",
-          "Saved: " + type_ + " " + range1.Stringify(key1) + " " +
-              range2.Stringify(key2));
+          "Saved: " + type_ + " " +
+              range1.Stringify(SequenceKey::Name(key1)) + " " +
+              range2.Stringify(SequenceKey::Name(key2)));
     }
   };
   if (data_.count({key2, key1})) {
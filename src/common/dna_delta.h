@@ -9,6 +9,8 @@
 
 #include "minimizer.h"
 #include "range.h"
+#include "sequence_arena.h"
+#include "sequence_key.h"
 
 class DnaDeltaBase {
  public:
@@ -25,26 +27,56 @@ class DnaDelta : public DnaDeltaBase {
   explicit DnaDelta(const std::string& type) : DnaDeltaBase{type} {}
 
   void Print(std::ofstream& out_file) const override;
-  void Set(const std::string& key, const Minimizer& value);
+  void Set(KeyId key, const Minimizer& value);
   void Merge(
-      const std::string& key_ref,
-      const std::string& key_seg = "",
+      KeyId key_ref,
+      KeyId key_seg = SequenceKey::NONE,
       const Range& range = {});
-  void Filter(const std::string& key_ref, const std::string& key_seg);
+  void Filter(KeyId key_ref, KeyId key_seg);
   double GetDensity(
-      const std::string& key,
-      const Range& range,
-      std::vector<Range>* delta_ranges_p);
+      KeyId key, const Range& range, std::vector<Range>* delta_ranges_p);
+  // Create the state of key, so that keys can be updated concurrently. The
+  // members updating a key reserve it too, and only look it up afterwards,
+  // which leaves the maps untouched once it is reserved.
+  void Reserve(KeyId key);
 
   friend class Dna;
+  friend class Test;
 
  protected:
   bool Combine(
-      Minimizer* base_p, const Minimizer* value_p, bool strict = true) const;
+      KeyId key,
+      Minimizer* base_p,
+      const Minimizer* value_p,
+      bool strict = true);
+  std::vector<size_t> Find(KeyId key, size_t start, size_t end) const;
+  void AddToIndex(KeyId key, size_t pos);
+  void Reindex(KeyId key, size_t from = 0);
 
  private:
-  std::unordered_map<std::string, std::vector<Minimizer>> data_;
-  std::unordered_map<std::string, std::vector<int>> density_;
+  static const size_t BUCKET_SIZE = 1024;
+
+  /**
+   * Positions in data_ of the deltas of a chromosome, in buckets of the ref
+   * positions they cover. Entries are added when deltas are saved, grown or
+   * moved, and never removed, so stale ones are skipped on lookup. Once
+   * they pile up, the whole index is rebuilt.
+   */
+  struct Index {
+    std::unordered_map<size_t, std::vector<size_t>> buckets_;
+    size_t entry_count_ = 0;
+    size_t rebuilt_count_ = 0;
+  };
+
+  void Add(Index* index_p, const Minimizer& delta, size_t pos);
+
+  std::unordered_map<KeyId, std::vector<Minimizer>> data_;
+  // Only Set, Merge and Filter keep the index valid. Dna edits data_ directly
+  // once all deltas are found, when the index is no longer used.
+  std::unordered_map<KeyId, Index> index_;
+  // Merged segments of the deltas of each chromosome, i.e. those without
+  // key_seg_.
+  std::unordered_map<KeyId, SequenceArena> arenas_;
 };
 
 class DnaMultiDelta : public DnaDeltaBase {
@@ -52,11 +84,7 @@ class DnaMultiDelta : public DnaDeltaBase {
   explicit DnaMultiDelta(const std::string& type) : DnaDeltaBase{type} {}
 
   void Print(std::ofstream& out_file) const override;
-  void Set(
-      const std::string& key1,
-      const Range& range1,
-      const std::string& key2,
-      const Range& range2);
+  void Set(KeyId key1, const Range& range1, KeyId key2, const Range& range2);
 
  protected:
   bool Combine(
@@ -73,7 +101,7 @@ class DnaMultiDelta : public DnaDeltaBase {
   };
 
   std::unordered_map<
-      std::pair<std::string, std::string>,
+      std::pair<KeyId, KeyId>,
       std::vector<std::pair<Range, Range>>,
       PairHash>
       data_;
@@ -0,0 +1,403 @@
+#include "dna_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "logger.h"
+#include "sequence.h"
+
+using std::array;
+using std::greater;
+using std::ifstream;
+using std::lower_bound;
+using std::max;
+using std::min;
+using std::move;
+using std::nth_element;
+using std::numeric_limits;
+using std::ofstream;
+using std::pair;
+using std::stable_sort;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace {
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+size_t Pad(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+}  // namespace
+
+DnaIndex::~DnaIndex() { Unmap(); }
+
+// Swapping the owned vectors keeps their buffers, so the views stay valid.
+void DnaIndex::swap(DnaIndex& that) noexcept {
+  using std::swap;
+  swap(keys_, that.keys_);
+  swap(values_, that.values_);
+  swap(checksum_, that.checksum_);
+  swap(hashes_, that.hashes_);
+  swap(offsets_, that.offsets_);
+  swap(entries_, that.entries_);
+  swap(hash_count_, that.hash_count_);
+  swap(entry_count_, that.entry_count_);
+  swap(max_occurrence_, that.max_occurrence_);
+  swap(hash_data_, that.hash_data_);
+  swap(offset_data_, that.offset_data_);
+  swap(entry_data_, that.entry_data_);
+  swap(map_p_, that.map_p_);
+  swap(map_size_, that.map_size_);
+  swap(pending_, that.pending_);
+}
+
+bool DnaIndex::IsBinary(const string& filename) {
+  ifstream in_file(filename, std::ios::binary);
+  char magic[sizeof(MAGIC)] = {};
+  in_file.read(magic, sizeof(magic));
+  return in_file && !memcmp(magic, MAGIC, sizeof(MAGIC));
+}
+
+uint32_t DnaIndex::AddKey(const string& key, const Sequence* value_p) {
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    if (keys_[i] == key) {
+      values_[i] = value_p;
+      return i;
+    }
+  }
+  assert(value_p->size() <= numeric_limits<uint32_t>::max());
+  keys_.push_back(key);
+  values_.push_back(value_p);
+  return keys_.size() - 1;
+}
+
+// Checksum of the chromosome names and the sequences they refer to.
+uint64_t DnaIndex::Checksum() const {
+  uint64_t hash = FNV_OFFSET;
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    assert(values_[i]);
+    for (auto c : keys_[i]) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+    }
+    hash = (hash ^ values_[i]->Checksum()) * FNV_PRIME;
+  }
+  return hash;
+}
+
+void DnaIndex::Insert(uint64_t hash, uint32_t key_id, size_t start) {
+  assert(key_id < keys_.size());
+  pending_.push_back({hash, {key_id, static_cast<uint32_t>(start)}});
+}
+
+void DnaIndex::Merge(const DnaIndex& that) {
+  assert(that.pending_.empty());
+  vector<uint32_t> key_ids;
+  for (size_t i = 0; i < that.keys_.size(); ++i) {
+    key_ids.push_back(AddKey(that.keys_[i], that.values_[i]));
+  }
+
+  for (size_t i = 0; i < that.hash_count_; ++i) {
+    for (auto j = that.offsets_[i]; j < that.offsets_[i + 1]; ++j) {
+      const auto& [key_id, start] = that.entries_[j];
+      Insert(that.hashes_[i], key_ids[key_id], start);
+    }
+  }
+  Build();
+}
+
+void DnaIndex::Build() {
+  if (pending_.empty()) return;
+
+  // Unpack the built entries so that new entries can be merged in.
+  vector<PendingEntry> entries;
+  entries.reserve(entry_count_ + pending_.size());
+  for (size_t i = 0; i < hash_count_; ++i) {
+    for (auto j = offsets_[i]; j < offsets_[i + 1]; ++j) {
+      entries.push_back({hashes_[i], entries_[j]});
+    }
+  }
+  entries.insert(entries.end(), pending_.begin(), pending_.end());
+  vector<PendingEntry>().swap(pending_);
+  assert(entries.size() <= numeric_limits<uint32_t>::max());
+
+  stable_sort(
+      entries.begin(),
+      entries.end(),
+      [](const PendingEntry& a, const PendingEntry& b) {
+        return a.hash_ < b.hash_;
+      });
+
+  Unmap();
+  hash_data_.clear();
+  offset_data_.clear();
+  entry_data_.clear();
+  entry_data_.reserve(entries.size());
+
+  for (const auto& [hash, entry] : entries) {
+    if (hash_data_.empty() || hash_data_.back() != hash) {
+      hash_data_.push_back(hash);
+      offset_data_.push_back(entry_data_.size());
+    }
+    entry_data_.push_back(entry);
+  }
+  offset_data_.push_back(entry_data_.size());
+
+  hash_data_.shrink_to_fit();
+  offset_data_.shrink_to_fit();
+
+  hashes_ = hash_data_.data();
+  offsets_ = offset_data_.data();
+  entries_ = entry_data_.data();
+  hash_count_ = hash_data_.size();
+  entry_count_ = entry_data_.size();
+  max_occurrence_ = MaxOccurrence();
+}
+
+// Whether every minimizer lies within its chromosome, once all chromosomes are
+// attached.
+bool DnaIndex::CheckEntries() const {
+  for (size_t i = 0; i < entry_count_; ++i) {
+    const auto& [key_id, start] = entries_[i];
+    const auto* value_p = values_[key_id];
+    if (!value_p || start + Config::HASH_SIZE > value_p->size()) return false;
+  }
+  return true;
+}
+
+pair<const DnaIndex::Entry*, const DnaIndex::Entry*> DnaIndex::Find(
+    uint64_t hash) const {
+  assert(pending_.empty());
+  auto hash_p = lower_bound(hashes_, hashes_ + hash_count_, hash);
+  if (hash_p == hashes_ + hash_count_ || *hash_p != hash) {
+    return {nullptr, nullptr};
+  }
+
+  auto i = hash_p - hashes_;
+  return {entries_ + offsets_[i], entries_ + offsets_[i + 1]};
+}
+
+// Entries of hash and of hash + 1, such as the two strands of a canonical
+// k-mer, which are adjacent in hashes_ and found with one search.
+array<pair<const DnaIndex::Entry*, const DnaIndex::Entry*>, 2>
+DnaIndex::FindPair(uint64_t hash) const {
+  assert(pending_.empty());
+  array<pair<const Entry*, const Entry*>, 2> entries{};
+  auto i = lower_bound(hashes_, hashes_ + hash_count_, hash) - hashes_;
+  for (auto& [entry_begin, entry_end] : entries) {
+    if (static_cast<size_t>(i) < hash_count_ && hashes_[i] == hash) {
+      entry_begin = entries_ + offsets_[i];
+      entry_end = entries_ + offsets_[i + 1];
+      ++i;
+    }
+    ++hash;
+  }
+  return entries;
+}
+
+/**
+ * Map an index file written by Save() and use its arrays in place. The
+ * chromosome names are read, but not attached to any sequence: the caller
+ * should do so with AddKey(), compare Checksum() against checksum(), and
+ * then CheckEntries().
+ */
+bool DnaIndex::Load(const string& filename) {
+  auto fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    Logger::Error("DnaIndex::Load", "Input file " + filename + " not found");
+    return false;
+  }
+
+  struct stat file_stat;
+  size_t map_size = fstat(fd, &file_stat) ? 0 : file_stat.st_size;
+  auto map_p = map_size >= sizeof(Header)
+                   ? mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                   : MAP_FAILED;
+  close(fd);
+  if (map_p == MAP_FAILED) {
+    Logger::Error("DnaIndex::Load", "Cannot map input file " + filename);
+    return false;
+  }
+
+  auto fail = [&](const string& message) {
+    munmap(map_p, map_size);
+    Logger::Error("DnaIndex::Load", filename + ": " + message);
+    return false;
+  };
+
+  Header header;
+  memcpy(&header, map_p, sizeof(header));
+  if (memcmp(header.magic_, MAGIC, sizeof(MAGIC))) {
+    return fail("not an index file");
+  }
+  if (header.version_ != VERSION) {
+    return fail("unsupported version " + to_string(header.version_));
+  }
+  if (header.hash_size_ != Config::HASH_SIZE ||
+      header.window_size_ != Config::WINDOW_SIZE) {
+    return fail(
+        "created with hash size " + to_string(header.hash_size_) +
+        " and window size " + to_string(header.window_size_));
+  }
+  if (static_cast<bool>(header.flags_ & CANONICAL_FLAG) !=
+      Config::CANONICAL_KMERS) {
+    return fail(
+        Config::CANONICAL_KMERS ? "not created with canonical k-mers"
+                                : "created with canonical k-mers");
+  }
+
+  if (header.keys_size_ > map_size || header.hash_count_ > map_size ||
+      header.entry_count_ > map_size) {
+    return fail("unexpected file size " + to_string(map_size));
+  }
+
+  auto keys_p = static_cast<const char*>(map_p) + sizeof(Header);
+  auto hashes_p = keys_p + header.keys_size_;
+  auto offsets_p = hashes_p + header.hash_count_ * sizeof(uint64_t);
+  auto entries_p =
+      offsets_p + Pad((header.hash_count_ + 1) * sizeof(uint32_t));
+  auto end_p = entries_p + header.entry_count_ * sizeof(Entry);
+  if (end_p != static_cast<const char*>(map_p) + map_size) {
+    return fail("unexpected file size " + to_string(map_size));
+  }
+
+  vector<string> keys;
+  for (auto key_p = keys_p; keys.size() < header.key_count_;) {
+    auto key_end_p = static_cast<const char*>(
+        memchr(key_p, '\0', hashes_p - key_p));
+    if (!key_end_p) return fail("corrupted chromosome names");
+    keys.emplace_back(key_p, key_end_p);
+    key_p = key_end_p + 1;
+  }
+
+  // Lookups search hashes and trust offsets and key ids, so a corrupted body
+  // is rejected here, rather than read out of bounds later.
+  auto hashes = reinterpret_cast<const uint64_t*>(hashes_p);
+  auto offsets = reinterpret_cast<const uint32_t*>(offsets_p);
+  auto entries = reinterpret_cast<const Entry*>(entries_p);
+  if (offsets[0] || offsets[header.hash_count_] != header.entry_count_) {
+    return fail("corrupted offsets");
+  }
+  for (size_t i = 0; i < header.hash_count_; ++i) {
+    if (offsets[i] > offsets[i + 1]) return fail("corrupted offsets");
+    if (i && hashes[i - 1] >= hashes[i]) return fail("corrupted hashes");
+  }
+  for (size_t i = 0; i < header.entry_count_; ++i) {
+    if (entries[i].key_id_ >= header.key_count_) {
+      return fail("corrupted entries");
+    }
+  }
+
+  Unmap();
+  hash_data_.clear();
+  offset_data_.clear();
+  entry_data_.clear();
+  pending_.clear();
+
+  keys_ = move(keys);
+  values_.assign(keys_.size(), nullptr);
+  checksum_ = header.checksum_;
+
+  hashes_ = hashes;
+  offsets_ = offsets;
+  entries_ = entries;
+  hash_count_ = header.hash_count_;
+  entry_count_ = header.entry_count_;
+  map_p_ = map_p;
+  map_size_ = map_size;
+  max_occurrence_ = MaxOccurrence();
+  return true;
+}
+
+bool DnaIndex::Save(const string& filename) const {
+  assert(pending_.empty());
+  ofstream out_file(filename, std::ios::binary);
+  if (!out_file) {
+    Logger::Error("DnaIndex::Save", "Cannot create output file " + filename);
+    return false;
+  }
+
+  string keys;
+  for (const auto& key : keys_) {
+    keys += key;
+    keys += '\0';
+  }
+  keys.resize(Pad(keys.size()), '\0');
+
+  Header header;
+  memcpy(header.magic_, MAGIC, sizeof(MAGIC));
+  header.version_ = VERSION;
+  header.hash_size_ = Config::HASH_SIZE;
+  header.window_size_ = Config::WINDOW_SIZE;
+  header.key_count_ = keys_.size();
+  header.checksum_ = Checksum();
+  header.hash_count_ = hash_count_;
+  header.entry_count_ = entry_count_;
+  header.keys_size_ = keys.size();
+  header.flags_ = Config::CANONICAL_KMERS ? CANONICAL_FLAG : 0;
+
+  auto write = [&out_file](const void* data_p, size_t size) {
+    out_file.write(static_cast<const char*>(data_p), size);
+  };
+
+  auto offsets_size = (hash_count_ + 1) * sizeof(uint32_t);
+  const uint32_t empty_offsets[] = {0};
+  const char padding[8] = {};
+
+  write(&header, sizeof(header));
+  write(keys.data(), keys.size());
+  write(hashes_, hash_count_ * sizeof(uint64_t));
+  write(offsets_ ? offsets_ : empty_offsets, offsets_size);
+  write(padding, Pad(offsets_size) - offsets_size);
+  write(entries_, entry_count_ * sizeof(Entry));
+
+  out_file.close();
+  return static_cast<bool>(out_file);
+}
+
+void DnaIndex::Unmap() {
+  if (map_p_) {
+    munmap(map_p_, map_size_);
+    map_p_ = nullptr;
+    map_size_ = 0;
+  }
+}
+
+/**
+ * The number of entries above which a hash is too frequent to be looked up,
+ * following Config::MINIMIZER_MAX_OCCURRENCE. Entry counts are taken from the
+ * offsets, so they need not be stored separately.
+ */
+size_t DnaIndex::MaxOccurrence() const {
+  if (Config::MINIMIZER_MAX_OCCURRENCE) return Config::MINIMIZER_MAX_OCCURRENCE;
+  if (!hash_count_) return Config::MINIMIZER_MIN_OCCURRENCE;
+
+  vector<uint32_t> counts(hash_count_);
+  for (size_t i = 0; i < hash_count_; ++i) {
+    counts[i] = offsets_[i + 1] - offsets_[i];
+  }
+  auto skip_count = min(
+      static_cast<size_t>(hash_count_ * Config::MINIMIZER_MAX_OCCURRENCE_RATE),
+      hash_count_ - 1);
+  nth_element(
+      counts.begin(),
+      counts.begin() + skip_count,
+      counts.end(),
+      greater<uint32_t>());
+  return max<size_t>(counts[skip_count], Config::MINIMIZER_MIN_OCCURRENCE);
+}
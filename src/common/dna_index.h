@@ -0,0 +1,109 @@
+#ifndef SRC_COMMON_DNA_INDEX_H_
+#define SRC_COMMON_DNA_INDEX_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sequence.h"
+
+/**
+ * A flat minimizer index. Entries are grouped by hash: hashes_ is sorted and
+ * the entries of hashes_[i] are entries_[offsets_[i], offsets_[i + 1]).
+ * Chromosomes are referred to by id, and each entry only stores its start,
+ * since every minimizer spans Config::HASH_SIZE bases.
+ *
+ * The arrays are either owned by the index or mapped from an index file, which
+ * stores them in the same layout after a header and the chromosome names.
+ */
+class DnaIndex {
+ public:
+  struct Entry {
+    uint32_t key_id_;
+    uint32_t start_;
+  };
+
+  DnaIndex() {}
+  DnaIndex(const DnaIndex&) = delete;
+  DnaIndex& operator=(const DnaIndex&) = delete;
+  ~DnaIndex();
+
+  void swap(DnaIndex& that) noexcept;
+
+  static bool IsBinary(const std::string& filename);
+
+  size_t size() const { return entry_count_ + pending_.size(); }
+  size_t key_count() const { return keys_.size(); }
+  uint32_t AddKey(const std::string& key, const Sequence* value_p);
+  const std::string& key(uint32_t key_id) const { return keys_[key_id]; }
+  const Sequence* value(uint32_t key_id) const { return values_[key_id]; }
+  uint64_t checksum() const { return checksum_; }
+  uint64_t Checksum() const;
+  bool CheckEntries() const;
+
+  void Insert(uint64_t hash, uint32_t key_id, size_t start);
+  void Merge(const DnaIndex& that);
+  void Build();
+  std::pair<const Entry*, const Entry*> Find(uint64_t hash) const;
+  std::array<std::pair<const Entry*, const Entry*>, 2> FindPair(
+      uint64_t hash) const;
+  size_t max_occurrence() const { return max_occurrence_; }
+
+  bool Load(const std::string& filename);
+  bool Save(const std::string& filename) const;
+
+ private:
+  static constexpr char MAGIC[8] = {'D', 'N', 'A', 'I', 'D', 'X', 0, 0};
+  static constexpr uint32_t VERSION = 2;
+  // Set in Header::flags_ if the index holds canonical k-mers.
+  static constexpr uint64_t CANONICAL_FLAG = 1;
+
+  struct Header {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t hash_size_;
+    uint32_t window_size_;
+    uint32_t key_count_;
+    uint64_t checksum_;
+    uint64_t hash_count_;
+    uint64_t entry_count_;
+    // Size of the chromosome names, padded to a multiple of 8 bytes.
+    uint64_t keys_size_;
+    uint64_t flags_;
+  };
+
+  struct PendingEntry {
+    uint64_t hash_;
+    Entry entry_;
+  };
+
+  void Unmap();
+  size_t MaxOccurrence() const;
+
+  std::vector<std::string> keys_;
+  std::vector<const Sequence*> values_;
+  // Checksum of the reference data, as recorded in the loaded index file.
+  uint64_t checksum_ = 0;
+
+  const uint64_t* hashes_ = nullptr;
+  const uint32_t* offsets_ = nullptr;
+  const Entry* entries_ = nullptr;
+  size_t hash_count_ = 0;
+  size_t entry_count_ = 0;
+  // Hashes with more entries are skipped by lookups for reads.
+  size_t max_occurrence_ = 0;
+
+  std::vector<uint64_t> hash_data_;
+  std::vector<uint32_t> offset_data_;
+  std::vector<Entry> entry_data_;
+
+  void* map_p_ = nullptr;
+  size_t map_size_ = 0;
+
+  // Entries inserted since the last Build().
+  std::vector<PendingEntry> pending_;
+};
+
+#endif  // SRC_COMMON_DNA_INDEX_H_
@@ -2,12 +2,15 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <fstream>
 #include <functional>
+#include <numeric>
 #include <queue>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -15,18 +18,22 @@
 #include "logger.h"
 #include "minimizer.h"
 #include "range.h"
+#include "sequence_key.h"
 #include "utils.h"
 
 using std::greater;
+using std::iota;
 using std::max;
 using std::min;
 using std::ofstream;
 using std::priority_queue;
+using std::stable_sort;
 using std::string;
 using std::swap;
 using std::to_string;
 using std::tuple;
 using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 
 size_t DnaOverlap::size() const {
@@ -37,106 +44,167 @@ size_t DnaOverlap::size() const {
   return size;
 }
 
-void DnaOverlap::Insert(const string& key_ref, const Minimizer& entry) {
+void DnaOverlap::Insert(KeyId key_ref, const Minimizer& entry) {
   data_[key_ref].emplace(entry);
 }
 
-void DnaOverlap::Merge() {
-  auto merge = [](const Range& base, const Range& range) {
-    assert(range.start_ < range.end_);
-    auto new_base = base;
-    if (base) {
-      assert(base.mode_ == range.mode_);
-      new_base.start_ = min(base.start_, range.start_);
-      new_base.end_ = max(base.end_, range.end_);
-    } else {
-      new_base = range;
+// Add the overlaps of one segment, found under no key, as those of key_seg.
+// Unless keep_value is set, they only keep the length of value_seg.
+void DnaOverlap::Add(
+    KeyId key_seg,
+    const Sequence& value_seg,
+    const DnaOverlap& that,
+    bool keep_value) {
+  if (!that.size()) return;
+  for (const auto& [key_ref, entries] : that.data_) {
+    for (const auto& [range_ref, key_entry, range_seg] : entries) {
+      auto new_range_seg = range_seg;
+      new_range_seg.value_p_ = keep_value ? &value_seg : nullptr;
+      Insert(key_ref, {range_ref, key_seg, new_range_seg});
     }
-    assert(new_base.start_ < new_base.end_);
-    assert(new_base.value_p_);
-    return new_base;
-  };
+  }
+  if (!keep_value) seg_sizes_[key_seg] = value_seg.size();
+}
 
-  for (auto&& [key_ref, entries] : data_) {
-    using MergedOverlap = tuple<Range, Range, size_t>;
-    unordered_map<string, vector<MergedOverlap>> merged_overlaps;
+/**
+ * Chain colinear anchors, i.e. the minimizers of one segment which keep their
+ * order on both the chromosome and the segment. Anchors are visited in order
+ * of their chromosome positions, and each one extends the best chain among its
+ * last Config::CHAIN_MAX_LOOKBACK predecessors. A chain gains up to HASH_SIZE
+ * for every anchor, and pays a log cost for the difference between the gaps on
+ * both sides, which must not exceed Config::MINIMIZER_MAX_DIFF. Chains are
+ * then taken from the best scored ends, skipping anchors already used.
+ */
+vector<DnaOverlap::Chain> DnaOverlap::FindChains(
+    const vector<Minimizer>& anchors) {
+  auto count = anchors.size();
+  vector<double> scores(count);
+  vector<size_t> prevs(count, count);
 
-    for (const auto& [range_ref, key_seg, range_seg] : entries) {
-      auto&& merged_overlaps_seg = merged_overlaps[key_seg];
-      auto merged = false;
-
-      for (auto&& [merged_ref, merged_seg, count] : merged_overlaps_seg) {
-        auto new_merged_ref = merge(merged_ref, range_ref);
-        auto new_merged_seg = merge(merged_seg, range_seg);
-        auto delta_ref = new_merged_ref.size() - merged_ref.size();
-        auto delta_seg = new_merged_seg.size() - merged_seg.size();
-
-        if (FuzzyCompare(delta_ref, delta_seg, Config::MINIMIZER_MAX_DIFF) &&
-            Verify(new_merged_ref, new_merged_seg)) {
-          merged_ref = new_merged_ref;
-          merged_seg = new_merged_seg;
-          ++count;
-          merged = true;
-          break;
-        }
+  for (size_t i = 0; i < count; ++i) {
+    const auto& range_ref = anchors[i].range_ref_;
+    const auto& range_seg = anchors[i].range_seg_;
+    scores[i] = Config::HASH_SIZE;
+
+    auto j_start = i - min(i, Config::CHAIN_MAX_LOOKBACK);
+    for (auto j = i; j-- > j_start;) {
+      const auto& prev_ref = anchors[j].range_ref_;
+      const auto& prev_seg = anchors[j].range_seg_;
+      if (prev_ref.start_ >= range_ref.start_ ||
+          prev_seg.start_ >= range_seg.start_) {
+        continue;
       }
 
-      if (!merged) {
-        merged_overlaps_seg.emplace_back(range_ref, range_seg, 1);
+      auto delta_ref = range_ref.start_ - prev_ref.start_;
+      auto delta_seg = range_seg.start_ - prev_seg.start_;
+      auto gap = max(delta_ref, delta_seg) - min(delta_ref, delta_seg);
+      if (gap > Config::MINIMIZER_MAX_DIFF) continue;
+
+      auto score = scores[j] + min({delta_ref, delta_seg, Config::HASH_SIZE}) -
+                   0.5 * log2(gap + 1.0);
+      if (score > scores[i]) {
+        scores[i] = score;
+        prevs[i] = j;
       }
     }
+  }
+
+  vector<size_t> ends(count);
+  iota(ends.begin(), ends.end(), 0);
+  stable_sort(ends.begin(), ends.end(), [&](size_t i, size_t j) {
+    return scores[i] > scores[j];
+  });
+
+  vector<Chain> chains;
+  vector<bool> used(count);
+  for (auto end : ends) {
+    if (used[end]) continue;
+    auto start = end;
+    size_t chain_count = 0;
+    for (auto i = end; i < count && !used[i]; i = prevs[i]) {
+      used[i] = true;
+      start = i;
+      ++chain_count;
+    }
+
+    auto chain_ref = anchors[end].range_ref_;
+    auto chain_seg = anchors[end].range_seg_;
+    chain_ref.start_ = anchors[start].range_ref_.start_;
+    chain_seg.start_ = anchors[start].range_seg_.start_;
+    chains.emplace_back(chain_ref, chain_seg, chain_count);
+  }
+  return chains;
+}
+
+void DnaOverlap::Merge() {
+  for (auto&& [key_ref, entries] : data_) {
+    const auto& name_ref = SequenceKey::Name(key_ref);
+
+    // Entries are sorted by their chromosome positions already.
+    unordered_map<KeyId, vector<Minimizer>> anchors;
+    for (const auto& entry : entries) {
+      anchors[entry.key_seg_].emplace_back(entry);
+    }
 
     entries.clear();
-    for (const auto& [key_seg, merged_overlaps_seg] : merged_overlaps) {
-      for (const auto& [merged_ref, merged_seg, count] : merged_overlaps_seg) {
+    for (const auto& [key_seg, anchors_seg] : anchors) {
+      auto chains = FindChains(anchors_seg);
+      for (const auto& [chain_ref, chain_seg, count] : chains) {
         auto used = count >= Config::MINIMIZER_MIN_COUNT &&
-                    merged_ref.size() >= Config::MINIMIZER_MIN_LEN &&
-                    merged_seg.size() >= Config::MINIMIZER_MIN_LEN;
+                    chain_ref.size() >= Config::MINIMIZER_MIN_LEN &&
+                    chain_seg.size() >= Config::MINIMIZER_MIN_LEN;
 
-        auto log_title = string("Mode: ") + to_string(merged_seg.mode_);
+        auto log_title = string("Mode: ") + to_string(chain_seg.mode_);
 
         if (used) {
-          entries.emplace(merged_ref, key_seg, merged_seg);
+          entries.emplace(chain_ref, key_seg, chain_seg);
 
-          Logger::Debug("DnaOverlap::Merge " + key_ref, log_title);
+          Logger::Debug("DnaOverlap::Merge " + name_ref, log_title);
           Logger::Debug("Minimizer count", to_string(count) + " used");
-          Logger::Trace("", "REF: \t" + merged_ref.Head());
-          Logger::Trace("", "SEG: \t" + merged_seg.Head());
+          Logger::Trace("", "REF: \t" + chain_ref.Head());
+          Logger::Trace("", "SEG: \t" + chain_seg.Head());
         } else {
-          Logger::Trace("DnaOverlap::Merge " + key_ref, log_title);
+          Logger::Trace("DnaOverlap::Merge " + name_ref, log_title);
           Logger::Trace("Minimizer count", to_string(count) + " not used");
-          Logger::Trace("", "REF: \t" + merged_ref.Head());
-          Logger::Trace("", "SEG: \t" + merged_seg.Head());
+          Logger::Trace("", "REF: \t" + chain_ref.Head());
+          Logger::Trace("", "SEG: \t" + chain_seg.Head());
         }
       }
     }
   }
 }
 
+/**
+ * Keep the reads of the sample covering each chromosome the most. A sample is
+ * named by the prefix of its reads, up to their first '_'.
+ */
 void DnaOverlap::SelectChain() {
+  auto prefixes = SequenceKey::Prefixes();
   for (auto&& [key_ref, entries] : data_) {
-    unordered_map<string, double> coverages;
+    vector<KeyId> keys;
+    unordered_set<KeyId> used_keys;
     auto max_coverage = 0.0;
-    string max_key;
+    auto max_key = SequenceKey::NONE;
 
     for (const auto& [range_ref, key_seg, range_seg] : entries) {
-      auto pos = key_seg.find('_');
-      assert(pos != string::npos);
-      auto key = key_seg.substr(0, pos);
-      coverages[key] = 0.0;
+      auto key = prefixes[key_seg];
+      assert(key != key_seg);
+      if (used_keys.insert(key).second) keys.push_back(key);
     }
 
-    for (auto&& [key, _coverage] : coverages) {
-      auto coverage = CheckCoverage(key_ref, key);
+    for (auto key : keys) {
+      auto coverage = CheckCoverage(key_ref, key, prefixes);
       if (coverage > max_coverage) {
         max_coverage = coverage;
         max_key = key;
       }
     }
-    Logger::Info("DnaOverlap::SelectChain " + key_ref, "Select " + max_key);
+    Logger::Info(
+        "DnaOverlap::SelectChain " + SequenceKey::Name(key_ref),
+        "Select " + SequenceKey::Name(max_key));
 
     for (auto entry_i = entries.begin(); entry_i != entries.end();) {
-      if (entry_i->key_seg_.compare(0, max_key.size(), max_key)) {
+      if (prefixes[entry_i->key_seg_] != max_key) {
         entry_i = entries.erase(entry_i);
       } else {
         ++entry_i;
@@ -145,18 +213,25 @@ void DnaOverlap::SelectChain() {
   }
 }
 
+double DnaOverlap::CheckCoverage(KeyId key_ref, KeyId key_sv) const {
+  if (key_sv == SequenceKey::NONE) return CheckCoverage(key_ref, key_sv, {});
+  return CheckCoverage(key_ref, key_sv, SequenceKey::Prefixes());
+}
+
 double DnaOverlap::CheckCoverage(
-    const string& key_ref, const string& key_sv) const {
+    KeyId key_ref, KeyId key_sv, const vector<KeyId>& prefixes) const {
   const auto& entries = data_.at(key_ref);
   if (!entries.size()) return 0.0;
 
   auto ref_size = entries.begin()->range_ref_.value_p_->size();
   vector<int> covered(ref_size + 1);
   for (const auto& [range_ref, key_seg, range_seg] : entries) {
-    if (key_sv.size() && key_seg.compare(0, key_sv.size(), key_sv)) continue;
+    if (key_sv != SequenceKey::NONE && prefixes[key_seg] != key_sv) continue;
 
     auto start_padding = range_seg.start_;
-    auto end_padding = range_seg.value_p_->size() - range_seg.end_;
+    auto seg_size = range_seg.value_p_ ? range_seg.value_p_->size()
+                                       : seg_sizes_.at(key_seg);
+    auto end_padding = seg_size - range_seg.end_;
     if (range_seg.mode_ == REVERSE || range_seg.mode_ == REVR_COMP) {
       swap(start_padding, end_padding);
     }
@@ -178,8 +253,8 @@ double DnaOverlap::CheckCoverage(
   covered_rate /= ref_size;
 
   Logger::Debug(
-      "DnaOverlap::CheckCoverage " + key_ref,
-      (key_sv.size() ? key_sv : "Total") +
+      "DnaOverlap::CheckCoverage " + SequenceKey::Name(key_ref),
+      (key_sv != SequenceKey::NONE ? SequenceKey::Name(key_sv) : "Total") +
           " cover rate: " + to_string(covered_rate * 100) + " %");
 
   return covered_rate;
@@ -205,6 +280,7 @@ DnaOverlap& DnaOverlap::operator+=(const DnaOverlap& that) {
       Insert(key_ref, entry);
     }
   }
+  seg_sizes_.insert(that.seg_sizes_.begin(), that.seg_sizes_.end());
   return *this;
 }
 
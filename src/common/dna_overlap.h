@@ -3,21 +3,28 @@
 
 #include <fstream>
 #include <set>
-#include <string>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include "minimizer.h"
+#include "sequence.h"
+#include "sequence_key.h"
 
 class DnaOverlap {
  public:
   DnaOverlap() {}
 
   size_t size() const;
-  void Insert(const std::string& key_ref, const Minimizer& entry);
+  void Insert(KeyId key_ref, const Minimizer& entry);
+  void Add(
+      KeyId key_seg,
+      const Sequence& value_seg,
+      const DnaOverlap& that,
+      bool keep_value = true);
   void Merge();
   void SelectChain();
-  double CheckCoverage(
-      const std::string& key_ref, const std::string& key_sv = "") const;
+  double CheckCoverage(KeyId key_ref, KeyId key_sv = SequenceKey::NONE) const;
   void CheckCoverage() const;
   void Print(std::ofstream& out_file) const;
 
@@ -25,9 +32,21 @@ class DnaOverlap {
   bool operator<(const DnaOverlap& that) const;
 
   friend class Dna;
+  friend class Bench;
+  friend class Test;
 
  private:
-  std::unordered_map<std::string, std::set<Minimizer>> data_;
+  // The ranges spanned by a chain of anchors, and the number of anchors.
+  using Chain = std::tuple<Range, Range, size_t>;
+
+  static std::vector<Chain> FindChains(const std::vector<Minimizer>& anchors);
+  // Coverage of key_ref by the reads whose prefix is key_sv, or all reads.
+  double CheckCoverage(
+      KeyId key_ref, KeyId key_sv, const std::vector<KeyId>& prefixes) const;
+
+  std::unordered_map<KeyId, std::set<Minimizer>> data_;
+  // Lengths of the segments added without their values.
+  std::unordered_map<KeyId, size_t> seg_sizes_;
 };
 
 #endif  // SRC_COMMON_DNA_OVERLAP_H_
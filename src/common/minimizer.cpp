@@ -2,10 +2,13 @@
 
 #include <string>
 
+#include "sequence_key.h"
+
 using std::string;
 
-string Minimizer::Stringify(const string& key_ref) const {
-  return range_ref_.Stringify(key_ref) + " " + range_seg_.Stringify(key_seg_);
+string Minimizer::Stringify(KeyId key_ref) const {
+  return range_ref_.Stringify(SequenceKey::Name(key_ref)) + " " +
+         range_seg_.Stringify(SequenceKey::Name(key_seg_));
 }
 
 bool Minimizer::operator<(const Minimizer& that) const {
@@ -4,22 +4,20 @@
 #include <string>
 
 #include "range.h"
+#include "sequence_key.h"
 
 struct Minimizer {
   Minimizer() {}
-  Minimizer(
-      const Range& range_ref,
-      const std::string& key_seg,
-      const Range& range_seg)
+  Minimizer(const Range& range_ref, KeyId key_seg, const Range& range_seg)
       : range_ref_(range_ref), key_seg_(key_seg), range_seg_(range_seg) {}
 
-  std::string Stringify(const std::string& key_ref = "") const;
+  std::string Stringify(KeyId key_ref = SequenceKey::NONE) const;
 
   bool operator<(const Minimizer& that) const;
   bool operator>(const Minimizer& that) const;
 
   Range range_ref_;
-  std::string key_seg_;
+  KeyId key_seg_ = SequenceKey::NONE;
   Range range_seg_;
 };
 
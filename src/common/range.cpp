@@ -8,6 +8,7 @@
 #include "logger.h"
 #include "utils.h"
 
+using std::max;
 using std::min;
 using std::string;
 using std::to_string;
@@ -22,8 +23,16 @@ string Range::get() const {
   return value_p_->substr(start_, size());
 }
 
+string Range::get(Mode mode) const {
+  assert(value_p_);
+  return value_p_->substr(start_, size(), mode);
+}
+
 string Range::Head(size_t start, size_t size) const {
-  return ::Head(get(), start, size);
+  assert(value_p_);
+  // Only unpack the displayed part of the sequence.
+  auto display_size = min(max(this->size(), start) - start, size);
+  return value_p_->substr(start_ + start, display_size);
 }
 
 string Range::Stringify() const {
@@ -4,20 +4,14 @@
 #include <string>
 
 #include "config.h"
-
-enum Mode {
-  NORMAL,
-  REVERSE,
-  COMPLEMENT,
-  REVR_COMP,
-};
+#include "sequence.h"
 
 struct Range {
   Range() {}
   Range(
       size_t start,
       size_t end,
-      const std::string* value_p,
+      const Sequence* value_p,
       Mode mode = NORMAL,
       bool unknown = false)
       : start_(start),
@@ -30,6 +24,7 @@ struct Range {
 
   size_t size() const;
   std::string get() const;
+  std::string get(Mode mode) const;
   std::string Head(size_t start = 0, size_t size = Config::DISPLAY_SIZE) const;
   std::string Stringify() const;
   std::string Stringify(const std::string& key) const;
@@ -41,7 +36,7 @@ struct Range {
 
   size_t start_ = 0;
   size_t end_ = 0;
-  const std::string* value_p_ = nullptr;
+  const Sequence* value_p_ = nullptr;
   Mode mode_ = NORMAL;
   bool unknown_ = false;
 };
@@ -0,0 +1,201 @@
+#include "sequence.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::min;
+using std::out_of_range;
+using std::prev;
+using std::pair;
+using std::reverse;
+using std::string;
+using std::swap;
+using std::upper_bound;
+
+Sequence::Sequence(const string& value) { Assign(value); }
+
+void Sequence::Assign(const string& value) {
+  size_ = value.size();
+  data_.assign(size_ / WORD_SIZE + 2, 0);
+  unknown_ranges_.clear();
+  unknown_words_.clear();
+
+  for (size_t i = 0; i < size_; ++i) {
+    uint64_t code = 0;
+    switch (value[i]) {
+      case 'A':
+      case 'a':
+        code = 0;
+        break;
+      case 'T':
+      case 't':
+        code = 1;
+        break;
+      case 'C':
+      case 'c':
+        code = 2;
+        break;
+      case 'G':
+      case 'g':
+        code = 3;
+        break;
+      default:
+        if (unknown_ranges_.size() && unknown_ranges_.back().second == i) {
+          ++unknown_ranges_.back().second;
+        } else {
+          unknown_ranges_.emplace_back(i, i + 1);
+        }
+        if (unknown_words_.empty()) {
+          unknown_words_.resize((data_.size() + 63) >> 6);
+        }
+        unknown_words_[(i / WORD_SIZE) >> 6] |= 1ull << ((i / WORD_SIZE) & 63);
+        break;
+    }
+    data_[i / WORD_SIZE] |= code << ((i % WORD_SIZE) << 1);
+  }
+}
+
+char Sequence::operator[](size_t pos) const {
+  return IsUnknown(pos) ? 'N' : BASES[code(pos)];
+}
+
+string Sequence::substr(size_t pos, size_t len) const {
+  return substr(pos, len, NORMAL);
+}
+
+/**
+ * Unpack this[pos, pos + len) as transformed by mode, e.g. the reverse
+ * complement of a segment, without unpacking it first. A complemented base
+ * is its code XOR 1, and 'N' stays 'N'.
+ */
+string Sequence::substr(size_t pos, size_t len, Mode mode) const {
+  // Like std::string::substr, which callers may rely on to reject pos.
+  if (pos > size_) throw out_of_range("Sequence::substr");
+  len = min(len, size_ - pos);
+  auto reversed = mode & REVERSE;
+  uint64_t complement = mode & COMPLEMENT ? 1 : 0;
+  auto index = [&](size_t i) { return reversed ? len - 1 - i : i; };
+
+  string value(len, 'N');
+  for (size_t i = 0; i < len; i += WORD_SIZE) {
+    auto word = Word(pos + i);
+    for (auto j = i; j < min(len, i + WORD_SIZE); ++j, word >>= 2) {
+      value[index(j)] = BASES[(word & 3) ^ complement];
+    }
+  }
+
+  auto range_i = upper_bound(
+      unknown_ranges_.begin(), unknown_ranges_.end(), pair{pos, size_});
+  if (range_i != unknown_ranges_.begin()) --range_i;
+  for (; range_i < unknown_ranges_.end() && range_i->first < pos + len;
+       ++range_i) {
+    auto start = range_i->first > pos ? range_i->first - pos : 0;
+    auto end = min(range_i->second, pos + len);
+    for (auto i = start; i + pos < end; ++i) {
+      value[index(i)] = 'N';
+    }
+  }
+  return value;
+}
+
+// Transform the sequence in place, working on whole words.
+void Sequence::Transform(Mode mode) {
+  if (mode & REVERSE) Reverse();
+  if (mode & COMPLEMENT) Complement();
+  if (mode != NORMAL) IndexUnknown();
+}
+
+void Sequence::Reverse() {
+  // Reverse the order of the 32 bases in a word.
+  auto reverse_word = [](uint64_t word) {
+    word = ((word >> 2) & 0x3333333333333333ull) |
+           ((word & 0x3333333333333333ull) << 2);
+    word = ((word >> 4) & 0x0f0f0f0f0f0f0f0full) |
+           ((word & 0x0f0f0f0f0f0f0f0full) << 4);
+    return __builtin_bswap64(word);
+  };
+
+  // Reversing the used words and their bases leaves the padding of the last
+  // word at the start, so the bases are then shifted down by its size. Word i
+  // only takes bits from words i and i + 1, which are still unshifted.
+  auto word_count = (size_ + WORD_SIZE - 1) / WORD_SIZE;
+  for (size_t i = 0; i < (word_count + 1) / 2; ++i) {
+    auto j = word_count - 1 - i;
+    auto word = reverse_word(data_[i]);
+    data_[i] = reverse_word(data_[j]);
+    data_[j] = word;
+  }
+
+  auto shift = (word_count * WORD_SIZE - size_) << 1;
+  if (shift) {
+    for (size_t i = 0; i < word_count; ++i) {
+      data_[i] = (data_[i] >> shift) | (data_[i + 1] << (64 - shift));
+    }
+  }
+
+  for (auto&& [start, end] : unknown_ranges_) {
+    start = size_ - start;
+    end = size_ - end;
+    swap(start, end);
+  }
+  reverse(unknown_ranges_.begin(), unknown_ranges_.end());
+}
+
+void Sequence::Complement() {
+  for (size_t i = 0; i * WORD_SIZE < size_; ++i) {
+    data_[i] ^= 0x5555555555555555ull;
+  }
+  // Keep the bits past the end clear, as Word() expects.
+  auto tail = size_ % WORD_SIZE;
+  if (tail) data_[size_ / WORD_SIZE] &= (1ull << (tail << 1)) - 1;
+}
+
+// Reset the codes of unknown bases to 0, and rebuild the bitmap of words
+// containing them.
+void Sequence::IndexUnknown() {
+  unknown_words_.clear();
+  if (unknown_ranges_.empty()) return;
+  unknown_words_.resize((data_.size() + 63) >> 6);
+  for (const auto& [start, end] : unknown_ranges_) {
+    for (auto i = start; i < end; ++i) {
+      data_[i / WORD_SIZE] &= ~(3ull << ((i % WORD_SIZE) << 1));
+      unknown_words_[(i / WORD_SIZE) >> 6] |= 1ull << ((i / WORD_SIZE) & 63);
+    }
+  }
+}
+
+// Return whether there is any 'N' in [start, end).
+bool Sequence::HasUnknown(size_t start, size_t end) const {
+  auto range_i = upper_bound(
+      unknown_ranges_.begin(), unknown_ranges_.end(), pair{start, size_});
+  if (range_i != unknown_ranges_.begin() && start < prev(range_i)->second) {
+    return true;
+  }
+  return range_i != unknown_ranges_.end() && range_i->first < end;
+}
+
+bool Sequence::FindUnknown(size_t pos) const {
+  auto range_i = upper_bound(
+      unknown_ranges_.begin(), unknown_ranges_.end(), pair{pos, size_});
+  return range_i != unknown_ranges_.begin() && pos < (--range_i)->second;
+}
+
+uint64_t Sequence::Checksum() const {
+  // FNV-1a over the packed words and the unknown ranges.
+  uint64_t hash = 14695981039346656037ull;
+  auto update = [&hash](uint64_t value) {
+    hash = (hash ^ value) * 1099511628211ull;
+  };
+
+  update(size_);
+  for (auto word : data_) update(word);
+  for (const auto& [start, end] : unknown_ranges_) {
+    update(start);
+    update(end);
+  }
+  return hash;
+}
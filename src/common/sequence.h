@@ -0,0 +1,121 @@
+#ifndef SRC_COMMON_SEQUENCE_H_
+#define SRC_COMMON_SEQUENCE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Bit 0 of a mode reverses a chain, and bit 1 complements it.
+enum Mode {
+  NORMAL,
+  REVERSE,
+  COMPLEMENT,
+  REVR_COMP,
+};
+
+/**
+ * A DNA sequence packed as 2 bits per base, using the same encoding as
+ * Dna::NextHash (A: 00, T: 01, C: 10, G: 11). Unknown bases 'N' are stored as
+ * 00, and their positions are kept in a sorted list of [start, end) runs.
+ * Besides, we mark each word containing 'N' in a bitmap, so that most lookups
+ * don't need to search the runs.
+ */
+class Sequence {
+ public:
+  Sequence() {}
+  explicit Sequence(const std::string& value);
+
+  // Replace the bases with value, reusing the allocated memory.
+  void Assign(const std::string& value);
+
+  size_t size() const { return size_; }
+  size_t length() const { return size_; }
+  char operator[](size_t pos) const;
+  uint64_t code(size_t pos) const;
+  std::string substr(size_t pos = 0, size_t len = std::string::npos) const;
+  std::string substr(size_t pos, size_t len, Mode mode) const;
+  void Transform(Mode mode);
+
+  bool IsUnknown(size_t pos) const;
+  bool HasUnknown(size_t start, size_t end) const;
+  uint64_t Checksum() const;
+  size_t Match(
+      size_t pos,
+      const Sequence& that,
+      size_t that_pos,
+      size_t max_len,
+      bool check_unknown = true) const;
+
+ private:
+  // Each 64-bit word stores 32 bases.
+  static constexpr size_t WORD_SIZE = 32;
+  static constexpr char BASES[] = "ATCG";
+
+  uint64_t Word(size_t pos) const;
+  bool FindUnknown(size_t pos) const;
+  void Reverse();
+  void Complement();
+  void IndexUnknown();
+
+  std::vector<uint64_t> data_;
+  std::vector<std::pair<size_t, size_t>> unknown_ranges_;
+  std::vector<uint64_t> unknown_words_;
+  size_t size_ = 0;
+};
+
+// The accessors below are used in the hot loops of Myers' algorithm.
+
+inline uint64_t Sequence::code(size_t pos) const {
+  return (data_[pos / WORD_SIZE] >> ((pos % WORD_SIZE) << 1)) & 3;
+}
+
+inline bool Sequence::IsUnknown(size_t pos) const {
+  if (unknown_ranges_.empty()) return false;
+  auto word_i = pos / WORD_SIZE;
+  return (unknown_words_[word_i >> 6] >> (word_i & 63) & 1) &&
+         FindUnknown(pos);
+}
+
+/**
+ * Return the length of the common prefix of this[pos:] and that[that_pos:],
+ * no longer than max_len. 'N' matches any base. We compare 32 bases at a time
+ * and only check the unknown ranges on a mismatch. If the caller knows there
+ * is no 'N' in both ranges, check_unknown can be false to skip the check.
+ */
+inline size_t Sequence::Match(
+    size_t pos,
+    const Sequence& that,
+    size_t that_pos,
+    size_t max_len,
+    bool check_unknown) const {
+  size_t len = 0;
+  while (len < max_len) {
+    auto diff = Word(pos + len) ^ that.Word(that_pos + len);
+    auto chunk_len = std::min(max_len - len, WORD_SIZE);
+    if (chunk_len < WORD_SIZE) diff &= (1ull << (chunk_len << 1)) - 1;
+
+    if (!diff) {
+      len += chunk_len;
+      continue;
+    }
+    len += __builtin_ctzll(diff) >> 1;
+    if (!check_unknown) break;
+    if (!IsUnknown(pos + len) && !that.IsUnknown(that_pos + len)) break;
+    ++len;
+  }
+  return len;
+}
+
+/**
+ * Return the codes of 32 bases starting from pos, padded with 0.
+ * data_ always ends with an extra empty word, so no bound check is needed.
+ */
+inline uint64_t Sequence::Word(size_t pos) const {
+  auto i = pos / WORD_SIZE;
+  auto offset = (pos % WORD_SIZE) << 1;
+  return (data_[i] >> offset) | ((data_[i + 1] << 1) << (63 - offset));
+}
+
+#endif  // SRC_COMMON_SEQUENCE_H_
@@ -0,0 +1,67 @@
+#include "sequence_arena.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "sequence.h"
+
+using std::less;
+using std::make_unique;
+using std::pair;
+using std::string;
+using std::upper_bound;
+
+const Sequence* SequenceArena::Create(const string& value) {
+  Sequence* value_p = nullptr;
+  if (free_.size()) {
+    value_p = free_.back();
+    free_.pop_back();
+  } else {
+    if (size_ == chunks_.size() * CHUNK_SIZE) {
+      const auto& chunk = chunks_.emplace_back(
+          make_unique<Sequence[]>(CHUNK_SIZE));
+      pair<const Sequence*, size_t> start{chunk.get(), chunks_.size() - 1};
+      auto before = [](const auto& a, const auto& b) {
+        return less<const Sequence*>()(a.first, b.first);
+      };
+      starts_.insert(
+          upper_bound(starts_.begin(), starts_.end(), start, before), start);
+      used_.resize(size_ + CHUNK_SIZE);
+      // Releases then never grow the free list.
+      free_.reserve(size_ + CHUNK_SIZE);
+    }
+    value_p = &chunks_[size_ / CHUNK_SIZE][size_ % CHUNK_SIZE];
+    ++size_;
+  }
+  value_p->Assign(value);
+  used_[Find(value_p)] = true;
+  return value_p;
+}
+
+void SequenceArena::Release(const Sequence* value_p) {
+  auto slot = Find(value_p);
+  if (slot == size_ || !used_[slot]) return;
+  used_[slot] = false;
+  // The arena owns the sequence, so it is safe to modify it again.
+  free_.push_back(const_cast<Sequence*>(value_p));
+}
+
+// Return the slot of value_p, or size_ if it is not in any chunk.
+size_t SequenceArena::Find(const Sequence* value_p) const {
+  less<const Sequence*> before;
+  auto start_i = upper_bound(
+      starts_.begin(),
+      starts_.end(),
+      value_p,
+      [&](const Sequence* value_p, const auto& start) {
+        return before(value_p, start.first);
+      });
+  if (start_i == starts_.begin()) return size_;
+  const auto& [start_p, chunk_i] = *--start_i;
+  if (!before(value_p, start_p + CHUNK_SIZE)) return size_;
+  auto slot = chunk_i * CHUNK_SIZE + (value_p - start_p);
+  return slot < size_ ? slot : size_;
+}
@@ -0,0 +1,46 @@
+#ifndef SRC_COMMON_SEQUENCE_ARENA_H_
+#define SRC_COMMON_SEQUENCE_ARENA_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sequence.h"
+
+/**
+ * An owner of sequences created on the fly, such as the merged segments of
+ * deltas. Sequences live in chunks of CHUNK_SIZE slots, so they keep their
+ * addresses until the arena is destroyed, when they are all freed at once.
+ * A released slot is reused by the next sequence created, along with its
+ * buffers. Ownership is kept in a bitmap of slots, found from an address by
+ * searching the chunks, so the arena itself allocates once per chunk. Merging
+ * still allocates whenever a sequence outgrows the buffers it reuses.
+ */
+class SequenceArena {
+ public:
+  SequenceArena() {}
+  SequenceArena(const SequenceArena&) = delete;
+  SequenceArena& operator=(const SequenceArena&) = delete;
+
+  const Sequence* Create(const std::string& value);
+  // Sequences not created by this arena are left alone, as deltas may be
+  // copied between owners.
+  void Release(const Sequence* value_p);
+
+ private:
+  static const size_t CHUNK_SIZE = 256;
+
+  size_t Find(const Sequence* value_p) const;
+
+  std::vector<std::unique_ptr<Sequence[]>> chunks_;
+  // Start addresses of the chunks, sorted, with their indexes in chunks_.
+  std::vector<std::pair<const Sequence*, size_t>> starts_;
+  // Whether each slot holds a sequence in use. Slot i is at
+  // chunks_[i / CHUNK_SIZE][i % CHUNK_SIZE].
+  std::vector<bool> used_;
+  size_t size_ = 0;
+  std::vector<Sequence*> free_;
+};
+
+#endif  // SRC_COMMON_SEQUENCE_ARENA_H_
@@ -0,0 +1,57 @@
+#include "sequence_key.h"
+
+#include <cassert>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::deque;
+using std::lock_guard;
+using std::mutex;
+using std::numeric_limits;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+deque<string> SequenceKey::names_{""};
+unordered_map<string, KeyId> SequenceKey::ids_{{"", SequenceKey::NONE}};
+vector<KeyId> SequenceKey::prefixes_{SequenceKey::NONE};
+mutex SequenceKey::mutex_;
+
+KeyId SequenceKey::Intern(const string& key) {
+  lock_guard<mutex> lock(mutex_);
+  return InternLocked(key);
+}
+
+vector<KeyId> SequenceKey::Prefixes() {
+  lock_guard<mutex> lock(mutex_);
+  return prefixes_;
+}
+
+KeyId SequenceKey::InternLocked(const string& key) {
+  auto [id_i, inserted] = ids_.emplace(key, names_.size());
+  auto key_id = id_i->second;
+  if (!inserted) return key_id;
+
+  assert(names_.size() < numeric_limits<KeyId>::max());
+  names_.push_back(key);
+  prefixes_.push_back(key_id);
+  auto pos = key.find('_');
+  if (pos != string::npos) prefixes_[key_id] = InternLocked(key.substr(0, pos));
+  return key_id;
+}
+
+KeyId SequenceKey::Find(const string& key) {
+  lock_guard<mutex> lock(mutex_);
+  auto id_i = ids_.find(key);
+  return id_i == ids_.end() ? NONE : id_i->second;
+}
+
+const string& SequenceKey::Name(KeyId key_id) {
+  lock_guard<mutex> lock(mutex_);
+  assert(key_id < names_.size());
+  return names_[key_id];
+}
@@ -0,0 +1,43 @@
+#ifndef SRC_COMMON_SEQUENCE_KEY_H_
+#define SRC_COMMON_SEQUENCE_KEY_H_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using KeyId = uint32_t;
+
+/**
+ * A registry of chromosome and segment names. Names are interned as they are
+ * imported, and everything else refers to them by dense ids, so that names are
+ * only looked up again when printing. Id 0 is the empty name, which marks
+ * deltas without a segment.
+ */
+class SequenceKey {
+ public:
+  static const KeyId NONE = 0;
+
+  static KeyId Intern(const std::string& key);
+  // Returns NONE if key has not been interned.
+  static KeyId Find(const std::string& key);
+  static const std::string& Name(KeyId key_id);
+  // Ids of the names up to their first '_', e.g. the sample of a read, indexed
+  // by key id. A name without '_' is its own prefix. They are interned along
+  // with the names, and copied at once, so that they can be compared without
+  // locking for each key.
+  static std::vector<KeyId> Prefixes();
+
+ private:
+  static KeyId InternLocked(const std::string& key);
+
+  // A deque, so that returned names stay valid while new ones are interned.
+  static std::deque<std::string> names_;
+  static std::unordered_map<std::string, KeyId> ids_;
+  static std::vector<KeyId> prefixes_;
+  static std::mutex mutex_;
+};
+
+#endif  // SRC_COMMON_SEQUENCE_KEY_H_
@@ -32,6 +32,10 @@ int main(int argc, char** argv) {
   fs::path deltas_filename(Config::DELTAS_FILENAME);
 
   Dna ref, sv, segments;
+  // With -a, the index and overlaps are passed on in memory, and only written
+  // to files if asked to with -o.
+  auto in_memory = arg_flags['a'];
+  auto print_all = !in_memory || arg_flags['o'];
 
   // Read reference data.
   if (!ref.Import(path / ref_filename)) {
@@ -41,29 +45,40 @@ int main(int argc, char** argv) {
   // Create an index of reference data.
   if (arg_flags['i']) {
     ref.CreateIndex();
-    ref.PrintIndex(path / index_filename);
+    if (print_all) {
+      ref.PrintIndex(path / index_filename);
+    }
   }
 
   // Find minimizers to match the PacBio subsequences to reference data.
   if (arg_flags['m']) {
-    if (!ref.ImportIndex(path / index_filename)) {
+    // An index created above is used as is, rather than merged with itself.
+    auto has_index = in_memory || arg_flags['i'];
+    if (!has_index && !ref.ImportIndex(path / index_filename)) {
       return EXIT_FAILURE;
     }
-    if (!segments.Import(path / seg_filename)) {
+    // Reads are only aligned later if they are passed on in memory.
+    auto keep_reads = in_memory && arg_flags['s'];
+    if (!segments.FindOverlaps(ref, path / seg_filename, keep_reads)) {
       return EXIT_FAILURE;
     }
-    segments.FindOverlaps(ref);
-    segments.PrintOverlaps(path / overlaps_filename);
+    if (print_all) {
+      segments.PrintOverlaps(path / overlaps_filename);
+    }
   }
 
   // Find SV deltas based on the reference data.
   if (arg_flags['s']) {
     if (!sv.Import(path / sv_filename)) {
-      if (!segments.Import(path / seg_filename)) {
-        return EXIT_FAILURE;
-      }
-      if (!ref.ImportOverlaps(&segments, path / overlaps_filename)) {
-        return EXIT_FAILURE;
+      if (in_memory) {
+        ref.ImportOverlaps(&segments);
+      } else {
+        if (!segments.Import(path / seg_filename)) {
+          return EXIT_FAILURE;
+        }
+        if (!ref.ImportOverlaps(&segments, path / overlaps_filename)) {
+          return EXIT_FAILURE;
+        }
       }
       ref.FindDeltasFromSegments();
     } else {
@@ -6,7 +6,7 @@ const char* Config::PATH = "tests/test_2";
 const char* Config::REF_FILENAME = "ref.fasta";
 const char* Config::SV_FILENAME = "sv.fasta";
 const char* Config::SEG_FILENAME = "long.fasta";
-const char* Config::INDEX_FILENAME = "index.txt";
+const char* Config::INDEX_FILENAME = "index.bin";
 const char* Config::OVERLAPS_FILENAME = "overlaps.txt";
 const char* Config::DELTAS_FILENAME = "sv.bed";
 
@@ -23,6 +23,11 @@ const size_t Config::DISPLAY_SIZE = 100;
 const size_t Config::HASH_SIZE = 15;
 const size_t Config::WINDOW_SIZE = 10;
 const size_t Config::CHUNK_SIZE = 50000;
+// Index k-mers and their reverse complements under one hash, with the strand
+// in the lowest bit. Reads are then looked up twice per position instead of
+// four times, as both strands are found with one search, but the minimizers
+// picked differ from the default index.
+const bool Config::CANONICAL_KMERS = false;
 
 // Finding minimizers
 
@@ -30,6 +35,16 @@ const size_t Config::OVERLAP_MIN_COUNT = 30;
 const size_t Config::MINIMIZER_MIN_COUNT = 5;
 const size_t Config::MINIMIZER_MIN_LEN = 1000;
 const size_t Config::MINIMIZER_MAX_DIFF = 1200;
+// Number of previous anchors tried when extending a chain.
+const size_t Config::CHAIN_MAX_LOOKBACK = 50;
+// Minimizers occurring more often than this in the reference are skipped when
+// mapping reads. 0 means skipping the given rate of the most frequent ones
+// instead, but never those occurring at most MINIMIZER_MIN_OCCURRENCE times.
+const size_t Config::MINIMIZER_MAX_OCCURRENCE = 0;
+const double Config::MINIMIZER_MAX_OCCURRENCE_RATE = 0.0002;
+const size_t Config::MINIMIZER_MIN_OCCURRENCE = 10;
+// Bases of reads loaded at a time when mapping them from a file.
+const size_t Config::READ_BATCH_SIZE = 1 << 26;
 
 // Finding deltas
 
@@ -40,11 +55,30 @@ const size_t Config::DELTA_IGNORE_LEN = 1;
 const size_t Config::DELTA_MIN_LEN = 100;
 const size_t Config::DELTA_MAX_LEN = 1000;
 const size_t Config::DELTA_ALLOW_LEN = 1500;
-const size_t Config::PADDING_SIZE = 60000;
 const size_t Config::SNAKE_MIN_LEN = 3;
 const int Config::DP_PENALTY = 2;
 const double Config::MYERS_PENALTY = 0.25;
 const double Config::ERROR_MAX_SCORE = 0.0;
+const bool Config::MYERS_LINEAR_SPACE = true;
+// Initial band of k-lines on both sides of the expected path, when aligning a
+// chunk to a known end. 0 disables the band.
+const size_t Config::MYERS_BAND_WIDTH = 1024;
+// Ref and sv are split at an exact match about every ANCHOR_INTERVAL bases, and
+// the windows between are aligned in parallel. 0 disables the split.
+const size_t Config::ANCHOR_INTERVAL = 100000;
+const size_t Config::ANCHOR_SIZE = 64;
+// How far the sv side of an anchor may drift from the previous one.
+const size_t Config::ANCHOR_MAX_SHIFT = 10000;
+// TRA pairs are picked among deltas whose sketches, i.e. the SKETCH_SIZE
+// smallest hashes of their SKETCH_HASH_SIZE-mers, share SKETCH_MIN_SHARED.
+const size_t Config::SKETCH_HASH_SIZE = 8;
+const size_t Config::SKETCH_SIZE = 32;
+const size_t Config::SKETCH_MIN_SHARED = 2;
+
+// Multithreading
+
+// 0 means using all hardware threads.
+const size_t Config::THREAD_COUNT = 0;
 
 // Utilities
 
@@ -36,6 +36,7 @@ struct Config {
   static const size_t HASH_SIZE;
   static const size_t WINDOW_SIZE;
   static const size_t CHUNK_SIZE;
+  static const bool CANONICAL_KMERS;
 
   // Finding minimizers
 
@@ -43,6 +44,11 @@ struct Config {
   static const size_t MINIMIZER_MIN_COUNT;
   static const size_t MINIMIZER_MIN_LEN;
   static const size_t MINIMIZER_MAX_DIFF;
+  static const size_t CHAIN_MAX_LOOKBACK;
+  static const size_t MINIMIZER_MAX_OCCURRENCE;
+  static const double MINIMIZER_MAX_OCCURRENCE_RATE;
+  static const size_t MINIMIZER_MIN_OCCURRENCE;
+  static const size_t READ_BATCH_SIZE;
 
   // Finding deltas
 
@@ -53,11 +59,22 @@ struct Config {
   static const size_t DELTA_MIN_LEN;
   static const size_t DELTA_MAX_LEN;
   static const size_t DELTA_ALLOW_LEN;
-  static const size_t PADDING_SIZE;
   static const size_t SNAKE_MIN_LEN;
   static const int DP_PENALTY;
   static const double MYERS_PENALTY;
   static const double ERROR_MAX_SCORE;
+  static const bool MYERS_LINEAR_SPACE;
+  static const size_t MYERS_BAND_WIDTH;
+  static const size_t ANCHOR_INTERVAL;
+  static const size_t ANCHOR_SIZE;
+  static const size_t ANCHOR_MAX_SHIFT;
+  static const size_t SKETCH_HASH_SIZE;
+  static const size_t SKETCH_SIZE;
+  static const size_t SKETCH_MIN_SHARED;
+
+  // Multithreading
+
+  static const size_t THREAD_COUNT;
 
   // Utilities
 
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include "config.h"
@@ -13,10 +14,14 @@ using std::cerr;
 using std::clog;
 using std::cout;
 using std::flush;
+using std::lock_guard;
+using std::mutex;
 using std::ofstream;
 using std::ostream;
 using std::string;
 
+mutex Logger::mutex_;
+
 bool Logger::Init() {
   fs::path log_path(Config::LOG_PATH);
   fs::path log_filename(Config::LOG_FILENAME);
@@ -43,48 +48,48 @@ bool Logger::Init() {
 
 void Logger::Trace(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::TRACE) {
-    clog << "[TRACE] ";
-    Log(clog, context, message, endl);
+    Log(clog, "[TRACE] ", context, message, endl);
   }
 }
 
 void Logger::Debug(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::DEBUG) {
-    clog << "[DEBUG] ";
-    Log(clog, context, message, endl);
+    Log(clog, "[DEBUG] ", context, message, endl);
   }
 }
 
 void Logger::Info(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::INFO) {
-    cout << "[INFO ] ";
-    Log(cout, context, message, endl);
+    Log(cout, "[INFO ] ", context, message, endl);
   }
 }
 
 void Logger::Warn(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::WARN) {
-    cerr << "[WARN ] ";
-    Log(cerr, context, message, endl);
+    Log(cerr, "[WARN ] ", context, message, endl);
   }
 }
 
 void Logger::Error(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::ERROR) {
-    cerr << "[ERROR] ";
-    Log(cerr, context, message, endl);
+    Log(cerr, "[ERROR] ", context, message, endl);
   }
 }
 
 void Logger::Fatal(const string& context, const string& message, bool endl) {
   if (Config::LOG_LEVEL <= Config::Level::FATAL) {
-    cerr << "[FATAL] ";
-    Log(cerr, context, message, endl);
+    Log(cerr, "[FATAL] ", context, message, endl);
   }
 }
 
 void Logger::Log(
-    ostream& output, const string& context, const string& message, bool endl) {
+    ostream& output,
+    const string& level,
+    const string& context,
+    const string& message,
+    bool endl) {
+  lock_guard<mutex> lock(mutex_);
+  output << level;
   if (context.length()) output << context << ": ";
   output << message;
   if (endl) output << "\n";
@@ -2,6 +2,7 @@
 #define SRC_UTILS_LOGGER_H_
 
 #include <iostream>
+#include <mutex>
 #include <string>
 
 class Logger {
@@ -24,9 +25,13 @@ class Logger {
  protected:
   static void Log(
       std::ostream& output,
+      const std::string& level,
       const std::string& context,
       const std::string& message,
       bool endl = true);
+
+  // Keeps lines from different threads apart.
+  static std::mutex mutex_;
 };
 
 #endif  // SRC_UTILS_LOGGER_H_
@@ -1,28 +1,32 @@
 #include "progress.h"
 
+#include <algorithm>
 #include <string>
 
 #include "logger.h"
 
+using std::min;
 using std::to_string;
 
 void Progress::Set(size_t cur) {
-  cur_ = cur < total_ ? cur : total_;
-  if (cur_ % step_ == 0 || cur_ == total_) {
-    Print(cur_ == total_);
-  }
+  cur_ = min(cur, total_);
+  Report(cur_);
 }
 
 void Progress::Print(bool endl) const {
-  Logger::Info(name_, to_string(cur_) + " / " + to_string(total_) + "\r", endl);
+  auto cur = min(cur_.load(), total_);
+  Logger::Info(name_, to_string(cur) + " / " + to_string(total_) + "\r", endl);
 }
 
-Progress& Progress::operator++() {
-  Set(cur_ + 1);
-  return *this;
-}
+Progress& Progress::operator++() { return *this += 1; }
 
 Progress& Progress::operator+=(size_t step) {
-  Set(cur_ + step);
+  Report(min(cur_ += step, total_));
   return *this;
 }
+
+void Progress::Report(size_t cur) const {
+  if (cur % step_ == 0 || cur == total_) {
+    Print(cur == total_);
+  }
+}
@@ -1,6 +1,7 @@
 #ifndef SRC_UTILS_PROGRESS_H_
 #define SRC_UTILS_PROGRESS_H_
 
+#include <atomic>
 #include <string>
 
 class Progress {
@@ -16,10 +17,13 @@ class Progress {
   Progress& operator+=(size_t step);
 
  private:
+  void Report(size_t cur) const;
+
   std::string name_;
   size_t total_;
   size_t step_;
-  size_t cur_;
+  // Workers of a parallel stage may share one progress bar.
+  std::atomic<size_t> cur_;
 };
 
 #endif  // SRC_UTILS_PROGRESS_H_
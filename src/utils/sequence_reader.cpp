@@ -0,0 +1,313 @@
+#include "sequence_reader.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "utils.h"
+
+using std::atomic;
+using std::ifstream;
+using std::max;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace {
+
+// Read a little-endian integer of size bytes.
+size_t ReadLittleEndian(const char* data_p, size_t size) {
+  size_t value = 0;
+  for (size_t i = size; i--;) {
+    value = (value << 8) | static_cast<unsigned char>(data_p[i]);
+  }
+  return value;
+}
+
+}  // namespace
+
+SequenceReader::SequenceReader(const string& filename)
+    : filename_(filename), buffer_(BUFFER_SIZE) {
+  in_file_.open(filename_, std::ios::binary | std::ios::ate);
+  if (!in_file_) {
+    filename_ = filename + ".gz";
+    in_file_.clear();
+    in_file_.open(filename_, std::ios::binary | std::ios::ate);
+  }
+  if (!in_file_) {
+    failed_ = true;
+    return;
+  }
+  file_size_ = in_file_.tellg();
+  in_file_.seekg(0);
+
+  format_ = Detect();
+  if (format_ == GZIP) {
+    input_.resize(BUFFER_SIZE);
+    // Accept gzip headers only, with the maximum window size.
+    if (inflateInit2(&stream_, 15 + 16) != Z_OK) {
+      format_ = PLAIN;
+      Fail("cannot initialize zlib");
+    }
+  }
+}
+
+SequenceReader::~SequenceReader() {
+  if (format_ == GZIP) inflateEnd(&stream_);
+}
+
+size_t SequenceReader::pos() const {
+  return format_ == PLAIN ? file_pos_ - (end_ - begin_) : file_pos_;
+}
+
+bool SequenceReader::Read(Record* record_p) {
+  auto&& [key, value] = *record_p;
+  key.clear();
+  value.clear();
+  if (failed_) return false;
+
+  auto c = Peek();
+  while (c == '\n' || c == '\r') {
+    ++begin_;
+    c = Peek();
+  }
+  if (c == EOF) return false;
+  if (c != '>' && c != '@') {
+    return Fail("unexpected '" + string(1, c) + "' before a header");
+  }
+
+  ReadLine(&line_);
+  auto key_end = line_.find_first_of(" \t", 1);
+  key = line_.substr(1, key_end == string::npos ? key_end : key_end - 1);
+  if (key.empty()) return Fail("empty header");
+
+  // A FASTA sequence runs until the next header, and a FASTQ one until '+'.
+  auto fastq = c == '@';
+  for (c = Peek(); c != EOF; c = Peek()) {
+    if (fastq ? c == '+' : c == '>' || c == '@') break;
+    ReadLine(&value, true);
+  }
+  if (!fastq) return true;
+
+  // Quality lines may start with any mark, so they are counted instead.
+  if (c == EOF) return Fail(key + " has no quality");
+  ReadLine(&line_);
+  size_t quality_size = 0;
+  while (quality_size < value.size() && ReadLine(&line_)) {
+    quality_size += line_.size();
+  }
+  if (quality_size != value.size()) {
+    return Fail(key + " has " + to_string(quality_size) + " quality values");
+  }
+  return true;
+}
+
+// Read records until their sequences add up to max_size, or the end of file.
+// Return the number of records read.
+size_t SequenceReader::Read(vector<Record>* records_p, size_t max_size) {
+  auto&& records = *records_p;
+  size_t count = 0, size = 0;
+  while (size < max_size) {
+    if (count == records.size()) records.emplace_back();
+    if (!Read(&records[count])) break;
+    size += records[count++].value_.size();
+  }
+  records.resize(count);
+  return count;
+}
+
+/**
+ * Tell the format from the gzip header. A BGZF block has an extra field, whose
+ * first subfield is 'BC' and holds the size of the block.
+ */
+SequenceReader::Format SequenceReader::Detect() {
+  char header[18] = {};
+  in_file_.read(header, sizeof(header));
+  auto size = in_file_.gcount();
+  in_file_.clear();
+  in_file_.seekg(0);
+
+  auto gzip = size >= 10 && header[0] == '\x1f' && header[1] == '\x8b';
+  if (!gzip) return PLAIN;
+  auto bgzf = size == sizeof(header) && (header[3] & 4) &&
+              ReadLittleEndian(header + 10, 2) == 6 && header[12] == 'B' &&
+              header[13] == 'C' && ReadLittleEndian(header + 14, 2) == 2;
+  return bgzf ? BGZF : GZIP;
+}
+
+size_t SequenceReader::ReadFile(char* data_p, size_t size) {
+  in_file_.read(data_p, size);
+  size_t count = in_file_.gcount();
+  file_pos_ += count;
+  return count;
+}
+
+bool SequenceReader::Fill() {
+  if (begin_ < end_) return true;
+  if (failed_) return false;
+  begin_ = end_ = 0;
+
+  switch (format_) {
+    case GZIP:
+      return FillGzip();
+    case BGZF:
+      return FillBgzf();
+    case PLAIN:
+    default:
+      end_ = ReadFile(buffer_.data(), buffer_.size());
+      return end_ > 0;
+  }
+}
+
+// Inflate the next part of a gzip file. Concatenated gzip members are read as
+// one file.
+bool SequenceReader::FillGzip() {
+  while (!end_) {
+    if (!stream_.avail_in) {
+      stream_.next_in = reinterpret_cast<Bytef*>(input_.data());
+      stream_.avail_in = ReadFile(input_.data(), input_.size());
+      if (!stream_.avail_in) {
+        // total_in is reset at the end of each member.
+        return stream_.total_in ? Fail("truncated gzip file") : false;
+      }
+    }
+
+    stream_.next_out = reinterpret_cast<Bytef*>(buffer_.data());
+    stream_.avail_out = buffer_.size();
+    auto status = inflate(&stream_, Z_NO_FLUSH);
+    end_ = buffer_.size() - stream_.avail_out;
+
+    if (status == Z_STREAM_END) {
+      inflateReset(&stream_);
+    } else if (status != Z_OK && status != Z_BUF_ERROR) {
+      return Fail("corrupted gzip data");
+    }
+  }
+  return true;
+}
+
+/**
+ * Read the next BGZF_BATCH_SIZE blocks per thread, and inflate them on all
+ * threads at once. Each block holds its compressed size in its header, and its
+ * decompressed size in its trailer, so blocks can be placed in the buffer
+ * before they are inflated.
+ */
+bool SequenceReader::FillBgzf() {
+  struct Block {
+    size_t input_pos_;
+    size_t input_size_;
+    size_t output_pos_;
+    size_t output_size_;
+    uint32_t crc_;
+  };
+
+  const size_t header_size = 18;
+  const size_t trailer_size = 8;
+  vector<Block> blocks;
+  size_t output_size = 0;
+  input_.clear();
+
+  while (blocks.size() < BGZF_BATCH_SIZE * ThreadCount()) {
+    char header[header_size];
+    auto size = ReadFile(header, header_size);
+    if (!size) break;
+    if (size < header_size || header[0] != '\x1f' || header[1] != '\x8b' ||
+        header[12] != 'B' || header[13] != 'C') {
+      return Fail("corrupted BGZF block at " + to_string(file_pos_ - size));
+    }
+
+    auto block_size = ReadLittleEndian(header + 16, 2) + 1;
+    if (block_size < header_size + trailer_size) {
+      return Fail("corrupted BGZF block at " + to_string(file_pos_ - size));
+    }
+    auto input_pos = input_.size();
+    auto data_size = block_size - header_size;
+    input_.resize(input_pos + data_size);
+    if (ReadFile(input_.data() + input_pos, data_size) != data_size) {
+      return Fail("truncated BGZF block");
+    }
+
+    auto trailer_p = input_.data() + input_.size() - trailer_size;
+    auto block_output_size = ReadLittleEndian(trailer_p + 4, 4);
+    blocks.push_back({
+        input_pos,
+        data_size - trailer_size,
+        output_size,
+        block_output_size,
+        static_cast<uint32_t>(ReadLittleEndian(trailer_p, 4)),
+    });
+    output_size += block_output_size;
+  }
+  if (blocks.empty()) return false;
+
+  buffer_.resize(max(output_size, BUFFER_SIZE));
+  atomic<bool> ok{true};
+  ParallelFor(blocks.size(), [&](size_t i) {
+    const auto& block = blocks[i];
+    if (!block.output_size_) return;
+    auto output_p = reinterpret_cast<Bytef*>(buffer_.data()) + block.output_pos_;
+
+    z_stream stream = {};
+    // Blocks are raw deflate streams, as their headers are parsed above.
+    if (inflateInit2(&stream, -15) != Z_OK) {
+      ok = false;
+      return;
+    }
+    auto input_p = reinterpret_cast<Bytef*>(input_.data()) + block.input_pos_;
+    stream.next_in = input_p;
+    stream.avail_in = block.input_size_;
+    stream.next_out = output_p;
+    stream.avail_out = block.output_size_;
+    auto status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    if (status != Z_STREAM_END || stream.avail_out ||
+        crc32(0, output_p, block.output_size_) != block.crc_) {
+      ok = false;
+    }
+  });
+  if (!ok) return Fail("corrupted BGZF data");
+
+  end_ = output_size;
+  // Skip batches of empty blocks, such as the end-of-file marker.
+  return end_ ? true : Fill();
+}
+
+int SequenceReader::Peek() {
+  return Fill() ? static_cast<unsigned char>(buffer_[begin_]) : EOF;
+}
+
+// Read a line without its line break into line_p, or append it if asked to.
+// Return false at the end of file.
+bool SequenceReader::ReadLine(string* line_p, bool append) {
+  auto&& line = *line_p;
+  if (!append) line.clear();
+  if (!Fill()) return false;
+
+  while (Fill()) {
+    auto begin_p = buffer_.data() + begin_;
+    auto line_end_p = static_cast<char*>(memchr(begin_p, '\n', end_ - begin_));
+    auto chunk_end_p = line_end_p ? line_end_p : buffer_.data() + end_;
+    line.append(begin_p, chunk_end_p);
+    begin_ = chunk_end_p - buffer_.data();
+    if (line_end_p) {
+      ++begin_;
+      break;
+    }
+  }
+  if (line.size() && line.back() == '\r') line.pop_back();
+  return true;
+}
+
+bool SequenceReader::Fail(const string& message) {
+  Logger::Error("SequenceReader", filename_ + ": " + message);
+  failed_ = true;
+  return false;
+}
@@ -0,0 +1,82 @@
+#ifndef SRC_UTILS_SEQUENCE_READER_H_
+#define SRC_UTILS_SEQUENCE_READER_H_
+
+#include <zlib.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * A buffered reader of FASTA and FASTQ files, which yields one record or a
+ * batch of records at a time. Sequences may be wrapped over several lines, and
+ * FASTQ qualities are skipped. A record is keyed by the first word of its
+ * header line.
+ *
+ * Gzip files are decompressed on the fly, whichever their names are. BGZF
+ * files, i.e. gzip files made of independent blocks, are decompressed several
+ * blocks at a time on multiple threads.
+ */
+class SequenceReader {
+ public:
+  struct Record {
+    std::string key_;
+    std::string value_;
+  };
+
+  // If filename doesn't exist, filename.gz is read instead.
+  explicit SequenceReader(const std::string& filename);
+  SequenceReader(const SequenceReader&) = delete;
+  SequenceReader& operator=(const SequenceReader&) = delete;
+  ~SequenceReader();
+
+  // False if the file cannot be opened or is malformed.
+  operator bool() const { return !failed_; }
+
+  // Size of the file, and the number of bytes consumed so far. Both count
+  // compressed bytes for compressed files.
+  size_t size() const { return file_size_; }
+  size_t pos() const;
+
+  bool Read(Record* record_p);
+  size_t Read(std::vector<Record>* records_p, size_t max_size);
+
+  friend class Test;
+
+ private:
+  enum Format {
+    PLAIN,
+    GZIP,
+    BGZF,
+  };
+
+  static const size_t BUFFER_SIZE = 1 << 20;
+  // Number of BGZF blocks decompressed at a time per thread.
+  static const size_t BGZF_BATCH_SIZE = 16;
+
+  Format Detect();
+  size_t ReadFile(char* data_p, size_t size);
+  bool Fill();
+  bool FillGzip();
+  bool FillBgzf();
+  int Peek();
+  bool ReadLine(std::string* line_p, bool append = false);
+  bool Fail(const std::string& message);
+
+  std::string filename_;
+  std::ifstream in_file_;
+  size_t file_size_ = 0;
+  size_t file_pos_ = 0;
+  bool failed_ = false;
+
+  Format format_ = PLAIN;
+  z_stream stream_ = {};
+  std::vector<char> input_;
+
+  std::vector<char> buffer_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  std::string line_;
+};
+
+#endif  // SRC_UTILS_SEQUENCE_READER_H_
@@ -1,10 +1,13 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -14,13 +17,17 @@
 #include "point.h"
 #include "range.h"
 
+using std::atomic;
 using std::ceil;
 using std::cout;
+using std::function;
 using std::max;
 using std::min;
 using std::out_of_range;
 using std::pair;
 using std::string;
+using std::swap;
+using std::thread;
 using std::to_string;
 using std::unordered_map;
 using std::vector;
@@ -30,44 +37,85 @@ string Head(const string& value, size_t start, size_t size) {
   return value.substr(start, display_size);
 }
 
+/**
+ * Each cell of the DP only depends on its diagonal neighbour, so a single row
+ * is kept, and the diagonal value is carried along while the row is updated.
+ */
 pair<Range, Range> LongestCommonSubstring(
     const string& str1, const string& str2) {
   auto len1 = str1.length();
   auto len2 = str2.length();
-  vector<vector<int>> dp(len1 + 1, vector<int>(len2 + 1));
+  vector<int> dp(len2 + 1);
 
   auto substr_len = 0;
   Range str1_substr, str2_substr;
   for (auto i = 1ul; i <= len1; ++i) {
+    auto c1 = str1[i - 1];
+    // dp[i - 1][j - 1], and dp[i - 1][0] is always 0.
+    auto diagonal = 0;
     for (auto j = 1ul; j <= len2; ++j) {
-      auto c1 = str1[i - 1];
       auto c2 = str2[j - 1];
+      auto cur = diagonal;
       if (c1 == c2) {
-        dp[i][j] = dp[i - 1][j - 1] + 1;
-        if (dp[i][j] > substr_len) {
-          substr_len = dp[i][j];
+        ++cur;
+        if (cur > substr_len) {
+          substr_len = cur;
           str1_substr.end_ = i;
           str2_substr.end_ = j;
         }
-      } else if (c1 == 'N' || c2 == 'N') {
-        dp[i][j] = dp[i - 1][j - 1];
-      } else {
-        dp[i][j] = max(dp[i - 1][j - 1] - Config::DP_PENALTY, 0);
+      } else if (c1 != 'N' && c2 != 'N') {
+        cur = max(cur - Config::DP_PENALTY, 0);
       }
+      diagonal = dp[j];
+      dp[j] = cur;
     }
   }
 
   str1_substr.start_ = str1_substr.end_ - substr_len;
   str2_substr.start_ = str2_substr.end_ - substr_len;
-  str1_substr.value_p_ = &str1;
-  str2_substr.value_p_ = &str2;
   return {str1_substr, str2_substr};
 }
 
 size_t LongestCommonSubstringLength(const string& str1, const string& str2) {
-  return LongestCommonSubstring(str1, str2).first.get().length();
+  return LongestCommonSubstring(str1, str2).first.size();
 }
 
+namespace {
+
+// Fill dp_cur[j] from its diagonal, top and left neighbours, where a change of
+// direction costs DP_PENALTY.
+void LongestCommonSubsequenceStep(
+    const vector<pair<int, Direction>>& dp_prev,
+    vector<pair<int, Direction>>* dp_cur_p,
+    size_t j,
+    bool matched) {
+  auto&& dp_cur = *dp_cur_p;
+  auto& max_cur = dp_cur[j];
+  auto get_cur = [&max_cur](
+                     const pair<int, Direction>& prev, Direction direction) {
+    const auto& [prev_len, prev_direction] = prev;
+    auto cur = prev_len + (direction == TOP_LEFT);
+    if (prev_direction != direction) {
+      cur = max(cur - Config::DP_PENALTY, 0);
+    }
+    if (cur > max_cur.first) {
+      max_cur = {cur, direction};
+    }
+  };
+
+  if (matched) {
+    get_cur(dp_prev[j - 1], TOP_LEFT);
+  }
+  if (dp_prev[j] > dp_cur[j - 1]) {
+    get_cur(dp_prev[j], LEFT);
+  }
+  if (dp_prev[j] <= dp_cur[j - 1]) {
+    get_cur(dp_cur[j - 1], TOP);
+  }
+}
+
+}  // namespace
+
 vector<vector<pair<int, Direction>>> LongestCommonSubsequence(
     const string& str1, const string& str2) {
   auto len1 = str1.length();
@@ -82,40 +130,89 @@ vector<vector<pair<int, Direction>>> LongestCommonSubsequence(
 
   for (auto i = 1ul; i <= len1; ++i) {
     for (auto j = 1ul; j <= len2; ++j) {
-      auto& max_cur = dp[i][j];
-      auto get_cur =
-          [&max_cur](const pair<int, Direction>& prev, Direction direction) {
-            const auto& [prev_len, prev_direction] = prev;
-            auto cur = prev_len + (direction == TOP_LEFT);
-            if (prev_direction != direction) {
-              cur = max(cur - Config::DP_PENALTY, 0);
-            }
-            if (cur > max_cur.first) {
-              max_cur = {cur, direction};
-            }
-          };
-
-      auto c1 = str1[i - 1];
-      auto c2 = str2[j - 1];
-      if (c1 == c2) {
-        get_cur(dp[i - 1][j - 1], TOP_LEFT);
-      }
-      if (dp[i - 1][j] > dp[i][j - 1]) {
-        get_cur(dp[i - 1][j], LEFT);
-      }
-      if (dp[i - 1][j] <= dp[i][j - 1]) {
-        get_cur(dp[i][j - 1], TOP);
-      }
+      LongestCommonSubsequenceStep(
+          dp[i - 1], &dp[i], j, str1[i - 1] == str2[j - 1]);
     }
   }
   return dp;
 }
 
+// Same as LongestCommonSubsequence, but only two rows are kept.
 size_t LongestCommonSubsequenceLength(const string& str1, const string& str2) {
   auto len1 = str1.length();
   auto len2 = str2.length();
-  auto dp = LongestCommonSubsequence(str1, str2);
-  return dp[len1][len2].first;
+  vector<pair<int, Direction>> dp_prev(len2 + 1, {0, TOP_LEFT});
+  vector<pair<int, Direction>> dp_cur(len2 + 1, {0, TOP_LEFT});
+
+  for (auto i = 1ul; i <= len1; ++i) {
+    fill(dp_cur.begin(), dp_cur.end(), pair<int, Direction>{0, TOP_LEFT});
+    for (auto j = 1ul; j <= len2; ++j) {
+      LongestCommonSubsequenceStep(
+          dp_prev, &dp_cur, j, str1[i - 1] == str2[j - 1]);
+    }
+    swap(dp_prev, dp_cur);
+  }
+  return dp_prev[len2].first;
+}
+
+/**
+ * Length of the plain longest common subsequence, without penalties, which
+ * bounds both scores above. Bit i of V is 1 while str1[i] is unmatched, and
+ * each char of str2 updates V with V' = (V + (V & M)) | (V & ~M), where M
+ * marks its occurrences in str1 (Allison-Dix, Hyyro). A row of 64 bits takes
+ * a few word operations, so this runs in O(mn / 64) time and O(m) memory.
+ *
+ * If min_len is given, we stop once the length is known to reach min_len or
+ * not, and return the current lower or upper bound of it accordingly.
+ */
+size_t BitLcsLength(const string& str1, const string& str2, size_t min_len) {
+  auto len1 = str1.length();
+  auto len2 = str2.length();
+  auto word_count = (len1 + 63) / 64;
+  if (!len1 || !len2) return 0;
+
+  // Match masks of the distinct chars of str1, and one without any match.
+  vector<size_t> mask_ids(256, 0);
+  vector<uint64_t> masks(word_count, 0);
+  for (auto i = 0ul; i < len1; ++i) {
+    auto&& mask_id = mask_ids[static_cast<unsigned char>(str1[i])];
+    if (!mask_id) {
+      mask_id = masks.size() / word_count;
+      masks.resize(masks.size() + word_count, 0);
+    }
+    masks[mask_id * word_count + i / 64] |= 1ull << (i % 64);
+  }
+
+  vector<uint64_t> v(word_count, ~0ull);
+  if (len1 % 64) v.back() = (1ull << (len1 % 64)) - 1;
+  auto lcs_len = [&]() {
+    size_t unmatched = 0;
+    for (auto word : v) unmatched += __builtin_popcountll(word);
+    return len1 - unmatched;
+  };
+
+  for (auto j = 0ul; j < len2; ++j) {
+    auto mask_p =
+        &masks[mask_ids[static_cast<unsigned char>(str2[j])] * word_count];
+    uint64_t carry = 0;
+    for (auto k = 0ul; k < word_count; ++k) {
+      auto u = v[k] & mask_p[k];
+      auto sum = v[k] + u;
+      auto next_carry = sum < u;
+      sum += carry;
+      carry = next_carry || sum < carry;
+      v[k] = sum | (v[k] & ~mask_p[k]);
+    }
+    if (len1 % 64) v.back() &= (1ull << (len1 % 64)) - 1;
+
+    if (min_len && j % 64 == 63) {
+      auto cur_len = lcs_len();
+      if (cur_len >= min_len) return cur_len;
+      auto max_len = min(cur_len + len2 - j - 1, len1);
+      if (max_len < min_len) return max_len;
+    }
+  }
+  return lcs_len();
 }
 
 void Concat(string* base_p, const string* str_p) {
@@ -132,7 +229,7 @@ void Concat(string* base_p, const string* str_p) {
   auto base_suffix_str = base_p->substr(replace_start);
 
   auto common_str = LongestCommonSubstring(base_suffix_str, *str_p);
-  auto common_str_len = common_str.first.get().length();
+  auto common_str_len = common_str.first.size();
   if (common_str_len >= Config::OVERLAP_MIN_LEN) {
     Logger::Trace(
         "Concat",
@@ -158,12 +255,49 @@ bool FuzzyCompare(int num1, int num2, size_t threshold) {
   return abs(num1 - num2) <= threshold;
 }
 
+/**
+ * Both scores below never exceed the plain LCS length, which is much cheaper
+ * to bound with BitLcsLength. So each of their DP tables is only filled when
+ * the bound doesn't rule it out.
+ */
 bool FuzzyCompare(const string& str1, const string& str2) {
   auto max_len = max(str1.length(), str2.length());
-  return LongestCommonSubstringLength(str1, str2) >=
-             max_len * Config::STRICT_EQUAL_RATE ||
-         LongestCommonSubsequenceLength(str1, str2) >=
-             max_len * Config::FUZZY_EQUAL_RATE;
+  auto strict_len =
+      static_cast<size_t>(ceil(max_len * Config::STRICT_EQUAL_RATE));
+  auto fuzzy_len =
+      static_cast<size_t>(ceil(max_len * Config::FUZZY_EQUAL_RATE));
+
+  // Below fuzzy_len, lcs_len is an upper bound, whichever rate is higher.
+  auto lcs_len = BitLcsLength(str1, str2, fuzzy_len);
+  if (lcs_len < fuzzy_len && lcs_len < strict_len) return false;
+  if (LongestCommonSubstringLength(str1, str2) >= strict_len) return true;
+  return lcs_len >= fuzzy_len &&
+         LongestCommonSubsequenceLength(str1, str2) >= fuzzy_len;
+}
+
+size_t ThreadCount() {
+  if (Config::THREAD_COUNT) return Config::THREAD_COUNT;
+  return max(thread::hardware_concurrency(), 1u);
+}
+
+// Run task(i) for each i in [0, count), spread over ThreadCount() threads.
+// Tasks are handed out in order, one at a time.
+void ParallelFor(size_t count, const function<void(size_t)>& task) {
+  auto thread_count = min(ThreadCount(), count);
+  if (thread_count <= 1) {
+    for (size_t i = 0; i < count; ++i) task(i);
+    return;
+  }
+
+  atomic<size_t> next_i{0};
+  auto worker = [&]() {
+    for (auto i = next_i++; i < count; i = next_i++) task(i);
+  };
+
+  vector<thread> threads;
+  for (size_t i = 1; i < thread_count; ++i) threads.emplace_back(worker);
+  worker();
+  for (auto&& t : threads) t.join();
 }
 
 void ShowManual() {
@@ -172,7 +306,8 @@ void ShowManual() {
        << "-a\t : run all preprocessing tasks and start the main process\n"
        << "-i\t : create an index of reference data only\n"
        << "-m\t : find minimizers only\n"
-       << "-s\t : find sv deltas only\n";
+       << "-s\t : find sv deltas only\n"
+       << "-o\t : with -a, also write the index and minimizers to files\n";
 }
 
 bool ReadArgs(unordered_map<char, bool>* arg_flags, int argc, char** argv) {
@@ -184,6 +319,7 @@ bool ReadArgs(unordered_map<char, bool>* arg_flags, int argc, char** argv) {
         auto arg = argv[i][j];
         switch (arg) {
           case 'a':
+            (*arg_flags)['a'] = true;
             (*arg_flags)['i'] = true;
             (*arg_flags)['m'] = true;
             (*arg_flags)['s'] = true;
@@ -191,6 +327,7 @@ bool ReadArgs(unordered_map<char, bool>* arg_flags, int argc, char** argv) {
           case 'i':
           case 'm':
           case 's':
+          case 'o':
             (*arg_flags)[arg] = true;
             break;
           default:
@@ -1,6 +1,7 @@
 #ifndef SRC_UTILS_UTILS_H_
 #define SRC_UTILS_UTILS_H_
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -27,11 +28,17 @@ std::vector<std::vector<std::pair<int, Direction>>> LongestCommonSubsequence(
 size_t LongestCommonSubsequenceLength(
     const std::string& str1, const std::string& str2);
 
+size_t BitLcsLength(
+    const std::string& str1, const std::string& str2, size_t min_len = 0);
+
 void Concat(std::string* base_p, const std::string* str_p);
 
 bool FuzzyCompare(int num1, int num2, size_t threshold = Config::GAP_MAX_DIFF);
 bool FuzzyCompare(const std::string& str1, const std::string& str2);
 
+size_t ThreadCount();
+void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
 void ShowManual();
 bool ReadArgs(std::unordered_map<char, bool>* arg_flags, int argc, char** argv);
 
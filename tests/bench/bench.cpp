@@ -0,0 +1,42 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+
+#include "logger.h"
+
+using std::function;
+using std::min;
+using std::mt19937;
+using std::snprintf;
+using std::string;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+double Bench::Time(const function<void()>& task, size_t repeat) {
+  auto best = 0.0;
+  for (size_t i = 0; i < repeat; ++i) {
+    auto start = steady_clock::now();
+    task();
+    duration<double, std::milli> time = steady_clock::now() - start;
+    best = i ? min(best, time.count()) : time.count();
+  }
+  return best;
+}
+
+string Bench::RandomDna(size_t size, uint32_t seed) {
+  mt19937 engine(seed);
+  string value(size, 'N');
+  for (auto&& base : value) base = "ATCG"[engine() & 3];
+  return value;
+}
+
+void Bench::Report(const string& context, const string& name, double time) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%10.2f ms", time);
+  Logger::Info(context, name + buffer);
+}
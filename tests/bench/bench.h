@@ -0,0 +1,21 @@
+#ifndef TESTS_BENCH_BENCH_H_
+#define TESTS_BENCH_BENCH_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+class Bench {
+ public:
+  static void MinimizerBench();
+  static void ChainBench();
+
+ protected:
+  // Return the best wall time of several runs, in milliseconds.
+  static double Time(const std::function<void()>& task, size_t repeat = 3);
+  static std::string RandomDna(size_t size, uint32_t seed = 0);
+  static void Report(
+      const std::string& context, const std::string& name, double time);
+};
+
+#endif  // TESTS_BENCH_BENCH_H_
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bench.h"
+#include "config.h"
+#include "dna_overlap.h"
+#include "logger.h"
+#include "minimizer.h"
+#include "range.h"
+#include "sequence.h"
+#include "sequence_key.h"
+#include "utils.h"
+
+using std::max;
+using std::min;
+using std::mt19937;
+using std::sort;
+using std::string;
+using std::to_string;
+using std::tuple;
+using std::vector;
+
+// Compare DnaOverlap::FindChains with the greedy clustering that
+// DnaOverlap::Merge used before, on a read whose anchors are half colinear and
+// half scattered repeat hits. Each scattered hit starts a new cluster, which
+// every later anchor is tried against.
+void Bench::ChainBench() {
+  const size_t ref_size = 4000000;
+  const Sequence ref{RandomDna(ref_size)};
+  const Sequence seg{ref.substr(ref_size >> 1, ref_size >> 2)};
+  auto key_seg = SequenceKey::Intern("ChainBench");
+
+  auto find_clusters_greedy = [](const vector<Minimizer>& anchors) {
+    auto merge = [](const Range& base, const Range& range) {
+      auto new_base = range;
+      if (base) {
+        new_base.start_ = min(base.start_, range.start_);
+        new_base.end_ = max(base.end_, range.end_);
+      }
+      return new_base;
+    };
+
+    vector<tuple<Range, Range, size_t>> clusters;
+    for (const auto& [range_ref, key_seg, range_seg] : anchors) {
+      auto merged = false;
+      for (auto&& [cluster_ref, cluster_seg, count] : clusters) {
+        auto new_cluster_ref = merge(cluster_ref, range_ref);
+        auto new_cluster_seg = merge(cluster_seg, range_seg);
+        auto delta_ref = new_cluster_ref.size() - cluster_ref.size();
+        auto delta_seg = new_cluster_seg.size() - cluster_seg.size();
+
+        if (FuzzyCompare(delta_ref, delta_seg, Config::MINIMIZER_MAX_DIFF) &&
+            Verify(new_cluster_ref, new_cluster_seg)) {
+          cluster_ref = new_cluster_ref;
+          cluster_seg = new_cluster_seg;
+          ++count;
+          merged = true;
+          break;
+        }
+      }
+      if (!merged) clusters.emplace_back(range_ref, range_seg, 1);
+    }
+    return clusters;
+  };
+
+  for (size_t anchor_count : {1000, 4000, 16000}) {
+    // Anchors sorted by their reference positions, as DnaOverlap keeps them.
+    mt19937 engine(anchor_count);
+    vector<Minimizer> anchors;
+    auto step = seg.size() / (anchor_count >> 1);
+    for (size_t i = 0; i < anchor_count; ++i) {
+      auto seg_start = (i >> 1) * step;
+      auto ref_start = (ref_size >> 1) + seg_start;
+      if (i & 1) {
+        seg_start = engine() % (seg.size() - Config::HASH_SIZE);
+        ref_start = engine() % (ref_size - Config::HASH_SIZE);
+      }
+      anchors.emplace_back(
+          Range{ref_start, ref_start + Config::HASH_SIZE, &ref},
+          key_seg,
+          Range{seg_start, seg_start + Config::HASH_SIZE, &seg});
+    }
+    sort(anchors.begin(), anchors.end());
+
+    vector<DnaOverlap::Chain> chains;
+    auto greedy_time = Time([&]() { find_clusters_greedy(anchors); }, 1);
+    auto chain_time = Time([&]() { chains = DnaOverlap::FindChains(anchors); });
+
+    Logger::Info(__func__, to_string(anchor_count) + " anchors");
+    Report(__func__, "greedy clusters: ", greedy_time);
+    Report(__func__, "chaining:        ", chain_time);
+
+    auto best_count = 0ul;
+    for (const auto& [chain_ref, chain_seg, count] : chains) {
+      best_count = max(best_count, count);
+    }
+    if (best_count < (anchor_count >> 1)) {
+      Logger::Error(__func__, "Colinear anchors not chained");
+    }
+  }
+}
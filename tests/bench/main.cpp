@@ -0,0 +1,7 @@
+#include "bench.h"
+
+int main() {
+  Bench::MinimizerBench();
+  Bench::ChainBench();
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "config.h"
+#include "dna.h"
+#include "logger.h"
+#include "sequence.h"
+
+using std::pair;
+using std::priority_queue;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace {
+
+struct HashPos {
+  HashPos() {}
+  HashPos(uint64_t hash, size_t pos) : hash_(hash), pos_(pos) {}
+
+  bool operator<(const HashPos& that) const { return hash_ > that.hash_; }
+
+  uint64_t hash_ = 0;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+// Compare Dna::FindMinimizers with the lazily popped priority queue that
+// Dna::CreateIndex used before, on a multi-megabase reference.
+void Bench::MinimizerBench() {
+  const size_t size = 8000000;
+  const Sequence value{RandomDna(size)};
+
+  auto find_minimizers_heap = [&]() {
+    vector<pair<uint64_t, size_t>> minimizers;
+    uint64_t hash = 0;
+    for (size_t i = 0; i < Config::HASH_SIZE - 1; ++i) {
+      hash = Dna::NextHash(hash, value[i]);
+    }
+
+    priority_queue<HashPos> hashes;
+    HashPos prev_min_hash;
+    for (size_t i = 0; i < size - Config::HASH_SIZE + 1; ++i) {
+      while (hashes.size() && hashes.top().pos_ + Config::WINDOW_SIZE <= i) {
+        hashes.pop();
+      }
+      hash = Dna::NextHash(hash, value[i + Config::HASH_SIZE - 1]);
+      hashes.emplace(hash, i);
+
+      auto min_hash = hashes.top();
+      if (min_hash.pos_ != prev_min_hash.pos_) {
+        minimizers.emplace_back(min_hash.hash_, min_hash.pos_);
+        prev_min_hash = min_hash;
+      }
+    }
+    return minimizers;
+  };
+
+  vector<pair<uint64_t, size_t>> expected, got;
+  auto heap_time = Time([&]() { expected = find_minimizers_heap(); });
+  auto deque_time = Time([&]() { got = Dna::FindMinimizers(value); });
+
+  Logger::Info(
+      __func__,
+      to_string(size) + " bases, " + to_string(got.size()) + " minimizers");
+  Report(__func__, "priority queue: ", heap_time);
+  Report(__func__, "monotone queue: ", deque_time);
+  if (expected != got) {
+    Logger::Error(__func__, "Minimizers not matched");
+  }
+}
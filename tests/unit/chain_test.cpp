@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "config.h"
+#include "dna_overlap.h"
+#include "logger.h"
+#include "minimizer.h"
+#include "range.h"
+#include "sequence_key.h"
+#include "test.h"
+
+using std::get;
+using std::sort;
+using std::vector;
+
+void Test::ChainTest() {
+  auto key_seg = SequenceKey::Intern("ChainTest");
+  auto anchor = [&](size_t ref_start, size_t seg_start) {
+    return Minimizer{
+        {ref_start, ref_start + Config::HASH_SIZE, nullptr},
+        key_seg,
+        {seg_start, seg_start + Config::HASH_SIZE, nullptr},
+    };
+  };
+
+  // A segment matching ref[5000, 9000) every 50 bases, among repeat hits far
+  // off its diagonal, whose segment positions go backwards.
+  vector<Minimizer> anchors;
+  for (size_t pos = 0; pos < 4000; pos += 50) {
+    anchors.push_back(anchor(5000 + pos, pos));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    anchors.push_back(anchor(5425 + i * 200, 3900 - i * 100));
+  }
+  sort(anchors.begin(), anchors.end());
+
+  auto chains = DnaOverlap::FindChains(anchors);
+  Test::Expect(__func__, 9ul, chains.size());
+
+  const auto& [chain_ref, chain_seg, count] = chains.front();
+  Test::Expect(__func__, 80ul, count);
+  Test::Expect(__func__, 5000ul, chain_ref.start_);
+  Test::Expect(__func__, 8950 + Config::HASH_SIZE, chain_ref.end_);
+  Test::Expect(__func__, 0ul, chain_seg.start_);
+  Test::Expect(__func__, 3950 + Config::HASH_SIZE, chain_seg.end_);
+  for (size_t i = 1; i < chains.size(); ++i) {
+    Test::Expect(__func__, 1ul, get<2>(chains[i]));
+  }
+
+  Logger::Info(__func__, "Passed");
+}
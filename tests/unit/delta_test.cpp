@@ -0,0 +1,70 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dna_delta.h"
+#include "logger.h"
+#include "range.h"
+#include "sequence.h"
+#include "sequence_key.h"
+#include "test.h"
+
+using std::mt19937;
+using std::to_string;
+using std::vector;
+
+void Test::DeltaTest() {
+  mt19937 random(1);
+
+  const Sequence ref{RandomChain(&random, 200000)};
+  const Sequence seg{RandomChain(&random, 5000)};
+  auto key_ref = SequenceKey::Intern("DeltaTest");
+
+  // The positions Find should return, by a scan of all deltas.
+  DnaDelta deltas("DEL");
+  auto scan = [&](size_t start, size_t end) {
+    vector<size_t> positions;
+    const auto& key_deltas = deltas.data_.at(key_ref);
+    for (size_t pos = 0; pos < key_deltas.size(); ++pos) {
+      const auto& range_ref = key_deltas[pos].range_ref_;
+      if (range_ref.start_ <= end && range_ref.end_ >= start) {
+        positions.push_back(pos);
+      }
+    }
+    return positions;
+  };
+
+  /**
+   * Each read saves deltas, which grow the ones they overlap, then merges
+   * those within a range and drops the rest, and filters them by size. There
+   * are enough reads for the index to pile up stale entries and be rebuilt.
+   */
+  for (size_t read = 0; read < 40; ++read) {
+    auto key_seg = SequenceKey::Intern("DeltaTest_" + to_string(read));
+    for (size_t i = 0; i < 100; ++i) {
+      auto start = random() % (ref.size() - 2000);
+      auto size = 50 + random() % 1150;
+      auto seg_start = random() % (seg.size() - size);
+      deltas.Set(
+          key_ref,
+          {{start, start + size, &ref},
+           key_seg,
+           {seg_start, seg_start + size, &seg}});
+    }
+
+    auto range_start = random() % (ref.size() / 4);
+    Range range{range_start, range_start + ref.size() * 3 / 4, &ref};
+    deltas.Merge(key_ref, key_seg, range);
+    deltas.Filter(key_ref, key_seg);
+
+    for (size_t i = 0; i < 20; ++i) {
+      auto start = random() % ref.size();
+      auto end = start + random() % 3000;
+      Test::Expect(
+          __func__, true, deltas.Find(key_ref, start, end) == scan(start, end));
+    }
+  }
+  Test::Expect(__func__, true, deltas.index_.at(key_ref).rebuilt_count_ > 0);
+
+  Logger::Info(__func__, "Passed");
+}
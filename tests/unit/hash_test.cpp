@@ -2,8 +2,10 @@
 #include <utility>
 #include <vector>
 
+#include "config.h"
 #include "dna.h"
 #include "logger.h"
+#include "sequence.h"
 #include "test.h"
 
 using std::pair;
@@ -20,12 +22,34 @@ void Test::HashTest() {
       {"AACACGACCCCATGG", 36481567},
   };
 
+  string chain;
   for (const auto& [str, expected] : tests) {
     uint64_t hash = 0;
     for (auto base : str) {
       hash = Dna::NextHash(hash, base);
     }
     Test::Expect(__func__, expected, hash);
+    chain += str;
+  }
+
+  // Rolled hashes should match the ones computed base by base, both on the
+  // raw chain and on its packed sequence.
+  vector<uint64_t> hashes, packed_hashes;
+  Dna::RollHashes(chain, &hashes);
+  Dna::RollHashes(Sequence{chain}, 0, chain.size(), &packed_hashes);
+  Test::Expect(__func__, chain.size() - Config::HASH_SIZE + 1, hashes.size());
+  Test::Expect(__func__, hashes.size(), packed_hashes.size());
+
+  uint64_t hash = 0;
+  for (size_t i = 0; i < chain.size(); ++i) {
+    hash = Dna::NextHash(hash, chain[i]);
+    if (i + 1 < Config::HASH_SIZE) continue;
+    Test::Expect(__func__, hash, hashes[i + 1 - Config::HASH_SIZE]);
+    Test::Expect(__func__, hash, packed_hashes[i + 1 - Config::HASH_SIZE]);
+  }
+  for (size_t i = 0; i < tests.size(); ++i) {
+    const auto& expected = tests[i].second;
+    Test::Expect(__func__, expected, hashes[i * Config::HASH_SIZE]);
   }
 
   Logger::Info(__func__, "Passed");
@@ -0,0 +1,113 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "dna.h"
+#include "logger.h"
+#include "sequence.h"
+#include "sequence_key.h"
+#include "test.h"
+
+using std::fstream;
+using std::mt19937;
+using std::pair;
+using std::remove;
+using std::string;
+using std::vector;
+
+void Test::IndexTest() {
+  mt19937 random(1);
+  auto key1 = SequenceKey::Intern("index1");
+  auto key2 = SequenceKey::Intern("index2");
+  auto raw_value1 = RandomChain(&random, 5000);
+  auto raw_value2 = RandomChain(&random, 3000);
+
+  Dna ref;
+  ref.data_[key1] = Sequence(raw_value1);
+  ref.data_[key2] = Sequence(raw_value2);
+  ref.CreateIndex();
+
+  const string filename = "index_test.bin";
+  Test::Expect(__func__, true, ref.PrintIndex(filename));
+
+  // The loaded index has the same entries for every minimizer.
+  Dna loaded;
+  loaded.data_[key1] = Sequence(raw_value1);
+  loaded.data_[key2] = Sequence(raw_value2);
+  Test::Expect(__func__, true, loaded.ImportIndex(filename));
+  Test::Expect(__func__, ref.index_.size(), loaded.index_.size());
+  for (auto key : {key1, key2}) {
+    for (const auto& [hash, pos] : Dna::FindMinimizers(ref.data_[key])) {
+      auto [begin_p, end_p] = ref.index_.Find(hash);
+      auto [loaded_begin_p, loaded_end_p] = loaded.index_.Find(hash);
+      Test::Expect(__func__, end_p - begin_p, loaded_end_p - loaded_begin_p);
+      for (auto p = begin_p, q = loaded_begin_p; p < end_p; ++p, ++q) {
+        Test::Expect(__func__, p->key_id_, q->key_id_);
+        Test::Expect(__func__, p->start_, q->start_);
+      }
+    }
+  }
+
+  // Both strands of a canonical k-mer are found with one search.
+  for (const auto& [hash, pos] : Dna::FindMinimizers(ref.data_[key1])) {
+    auto entries = ref.index_.FindPair(hash & ~1ull);
+    Test::Expect(__func__, true, entries[0] == ref.index_.Find(hash & ~1ull));
+    Test::Expect(__func__, true, entries[1] == ref.index_.Find(hash | 1));
+  }
+
+  // An index of other reference data is rejected.
+  Dna other;
+  raw_value2[1000] = raw_value2[1000] == 'A' ? 'C' : 'A';
+  other.data_[key1] = Sequence(raw_value1);
+  other.data_[key2] = Sequence(raw_value2);
+  Test::Expect(__func__, false, other.ImportIndex(filename));
+  Test::Expect(__func__, 0ul, other.index_.size());
+
+  // So is an index with another version, hash size or window size. They are
+  // stored after the 8-byte magic.
+  auto patch = [&](size_t pos, uint32_t value) {
+    fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(pos);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto read = [&](size_t pos) {
+    uint64_t value = 0;
+    fstream file(filename, std::ios::in | std::ios::binary);
+    file.seekg(pos);
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+  };
+  auto patches = vector<pair<size_t, uint32_t>>{
+      {8, 0},
+      {12, Config::HASH_SIZE + 1},
+      {16, Config::WINDOW_SIZE + 1},
+  };
+
+  // And so is a corrupted body: hashes out of order, offsets going backwards,
+  // and entries of an unknown chromosome or past the end of theirs. The body
+  // follows the 64-byte header and the chromosome names.
+  auto hash_count = read(32);
+  auto hashes_pos = 64 + read(48);
+  auto offsets_pos = hashes_pos + hash_count * sizeof(uint64_t);
+  auto entries_pos = offsets_pos + (((hash_count + 1) * 4 + 7) & ~7ull);
+  patches.emplace_back(hashes_pos + 4, UINT32_MAX);
+  patches.emplace_back(offsets_pos + 4, UINT32_MAX);
+  patches.emplace_back(entries_pos, 2);
+  patches.emplace_back(entries_pos + 4, 5000);
+  for (const auto& [pos, value] : patches) {
+    ref.PrintIndex(filename);
+    patch(pos, value);
+    Dna patched;
+    patched.data_[key1] = Sequence(raw_value1);
+    patched.data_[key2] = ref.data_[key2];
+    Test::Expect(__func__, false, patched.ImportIndex(filename));
+  }
+
+  remove(filename.c_str());
+  Logger::Info(__func__, "Passed");
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "test.h"
+#include "utils.h"
+
+using std::max;
+using std::mt19937;
+using std::vector;
+
+void Test::LcsTest() {
+  mt19937 engine{42};
+
+  for (size_t len1 : {0, 1, 63, 64, 65, 200}) {
+    for (size_t len2 : {0, 5, 64, 150}) {
+      auto str1 = RandomChain(&engine, len1, "ATCGN");
+      auto str2 = RandomChain(&engine, len2, "ATCGN");
+
+      // The plain LCS by the textbook DP.
+      vector<vector<size_t>> dp(len1 + 1, vector<size_t>(len2 + 1));
+      for (size_t i = 1; i <= len1; ++i) {
+        for (size_t j = 1; j <= len2; ++j) {
+          dp[i][j] = str1[i - 1] == str2[j - 1]
+                         ? dp[i - 1][j - 1] + 1
+                         : max(dp[i - 1][j], dp[i][j - 1]);
+        }
+      }
+      auto expected = dp[len1][len2];
+      Test::Expect(__func__, expected, BitLcsLength(str1, str2));
+
+      // A bounded length is on the same side of min_len as the exact one.
+      for (auto min_len : {expected, expected + 1, expected / 2 + 1}) {
+        auto len = BitLcsLength(str1, str2, min_len);
+        Test::Expect(__func__, expected >= min_len, len >= min_len);
+      }
+
+      // Rows give the same penalized length as the full table.
+      auto table = LongestCommonSubsequence(str1, str2);
+      Test::Expect(
+          __func__,
+          static_cast<size_t>(table[len1][len2].first),
+          LongestCommonSubsequenceLength(str1, str2));
+    }
+  }
+
+  // 'N' neither counts nor costs in a common substring, while a mismatch
+  // costs DP_PENALTY.
+  auto [range1, range2] =
+      LongestCommonSubstring("GGACGTNCGTTA", "CCACGTACGTCC");
+  Test::Expect(__func__, 3ul, range1.start_);
+  Test::Expect(__func__, 10ul, range1.end_);
+  Test::Expect(__func__, 3ul, range2.start_);
+  Test::Expect(__func__, 10ul, range2.end_);
+  Test::Expect(
+      __func__, 3ul, LongestCommonSubstringLength("AAACGTTT", "GGACGAGG"));
+
+  Logger::Info(__func__, "Passed");
+}
@@ -1,6 +1,14 @@
 #include "test.h"
 
 int main() {
+  Test::ChainTest();
+  Test::DeltaTest();
   Test::HashTest();
+  Test::IndexTest();
+  Test::LcsTest();
+  Test::MyersTest();
+  Test::SequenceTest();
+  Test::SequenceReaderTest();
+  Test::TraTest();
   return 0;
 }
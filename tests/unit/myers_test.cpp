@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "dna.h"
+#include "logger.h"
+#include "minimizer.h"
+#include "sequence_key.h"
+#include "test.h"
+
+using std::max;
+using std::mt19937;
+using std::pair;
+using std::sort;
+using std::string;
+using std::tuple;
+using std::vector;
+
+void Test::MyersTest() {
+  const string raw_ref =
+      "TCAGGCTATCGTAGCCTAGATCCGATTGCAGTCAAGCTTGACCTAGTGCAATCGGTACTA";
+  const Sequence ref{raw_ref};
+  const Sequence sv{
+      raw_ref.substr(0, 20) + "GGTTGG" + raw_ref.substr(20, 20) +
+      raw_ref.substr(45)};
+
+  // {start, end} of the expected INS (on sv) and DEL (on ref) deltas.
+  auto tests = vector<tuple<string, size_t, size_t>>{
+      {"INS", 20, 26},
+      {"DEL", 40, 45},
+  };
+
+  auto key_ref = SequenceKey::Intern("ref");
+  auto key_sv = SequenceKey::Intern("sv");
+
+  Dna dna;
+  auto chunk_end = dna.FindDeltasChunkLinear(
+      key_ref, ref, 0, ref.size(), key_sv, sv, 0, sv.size(), true);
+  Test::Expect(__func__, static_cast<int>(ref.size()), chunk_end.x_);
+  Test::Expect(__func__, static_cast<int>(sv.size()), chunk_end.y_);
+
+  for (const auto& [type, start, end] : tests) {
+    const auto& deltas = type == "INS" ? dna.ins_deltas_.data_[key_ref]
+                                       : dna.del_deltas_.data_[key_ref];
+    Test::Expect(__func__, 1ul, deltas.size());
+
+    const auto& range = type == "INS" ? deltas.front().range_seg_
+                                      : deltas.front().range_ref_;
+    Test::Expect(__func__, start, range.start_);
+    Test::Expect(__func__, end, range.end_);
+  }
+
+  /**
+   * The linear-space variant ends where the quadratic one does, on random
+   * sequences with substitutions and short INS and DEL. Where several paths
+   * cost the same, the two may pick different ones, so we check that its
+   * deltas turn ref into sv at no more cost instead.
+   */
+  mt19937 random(1);
+  // Apply deltas to raw_ref[0, ref_end), and return the result and the cost.
+  auto apply = [](const Dna::ChunkDeltas& deltas,
+                  const string& raw_ref,
+                  size_t ref_end) {
+    vector<tuple<size_t, size_t, string>> edits;
+    size_t cost = 0;
+    for (const auto& [range_ref, key_seg, range_seg] : deltas.ins_) {
+      edits.emplace_back(range_ref.start_, 0, range_seg.get());
+      cost += range_seg.size();
+    }
+    for (const auto& [range_ref, key_seg, range_seg] : deltas.del_) {
+      edits.emplace_back(range_ref.start_, range_ref.size(), "");
+      cost += range_ref.size();
+    }
+    sort(edits.begin(), edits.end());
+
+    string result;
+    size_t pos = 0;
+    for (const auto& [start, size, value] : edits) {
+      result += raw_ref.substr(pos, start - pos) + value;
+      pos = start + size;
+    }
+    return pair{result + raw_ref.substr(pos, ref_end - pos), cost};
+  };
+
+  for (auto i = 0; i < 100; ++i) {
+    auto raw_ref = RandomChain(&random, 100 + random() % 900);
+    string raw_sv;
+    for (size_t pos = 0; pos < raw_ref.size();) {
+      auto size = 1 + random() % 20;
+      switch (random() % 8) {
+        case 0:
+          raw_sv += RandomChain(&random, size);
+          break;
+        case 1:
+          pos += size;
+          break;
+        case 2:
+          raw_sv += RandomChain(&random, 1);
+          ++pos;
+          break;
+        default:
+          raw_sv += raw_ref.substr(pos, size);
+          pos += size;
+          break;
+      }
+    }
+    const Sequence ref{raw_ref}, sv{raw_sv};
+
+    for (auto reach_end : {true, false}) {
+      Dna::ChunkDeltas expected, deltas;
+      auto expected_end = dna.FindDeltasChunkQuadratic(
+          key_ref,
+          ref,
+          0,
+          ref.size(),
+          key_sv,
+          sv,
+          0,
+          sv.size(),
+          true,
+          reach_end,
+          &expected);
+      auto end = dna.FindDeltasChunkLinear(
+          key_ref,
+          ref,
+          0,
+          ref.size(),
+          key_sv,
+          sv,
+          0,
+          sv.size(),
+          reach_end,
+          &deltas);
+
+      Test::Expect(__func__, expected_end.x_, end.x_);
+      Test::Expect(__func__, expected_end.y_, end.y_);
+      auto [expected_value, expected_cost] = apply(expected, raw_ref, end.x_);
+      auto [value, cost] = apply(deltas, raw_ref, end.x_);
+      Test::Expect(__func__, true, expected_value == raw_sv.substr(0, end.y_));
+      Test::Expect(__func__, true, value == raw_sv.substr(0, end.y_));
+      Test::Expect(__func__, true, cost <= expected_cost);
+    }
+  }
+
+  /**
+   * A DEL and then an INS, both longer than MYERS_BAND_WIDTH, take the path
+   * out of the first band, which is widened until the path fits. The middle
+   * is long enough that no path within the band could be as short.
+   */
+  auto size = Config::MYERS_BAND_WIDTH + 100;
+  auto raw_long_ref = RandomChain(&random, size * 5);
+  auto raw_long_sv = raw_long_ref.substr(0, size) +
+                     raw_long_ref.substr(size * 2, size * 2) +
+                     RandomChain(&random, size) + raw_long_ref.substr(size * 4);
+  const Sequence long_ref{raw_long_ref}, long_sv{raw_long_sv};
+
+  Dna::ChunkDeltas expected, deltas;
+  dna.FindDeltasChunkQuadratic(
+      key_ref,
+      long_ref,
+      0,
+      long_ref.size(),
+      key_sv,
+      long_sv,
+      0,
+      long_sv.size(),
+      true,
+      true,
+      &expected);
+  dna.FindDeltasChunkLinear(
+      key_ref,
+      long_ref,
+      0,
+      long_ref.size(),
+      key_sv,
+      long_sv,
+      0,
+      long_sv.size(),
+      true,
+      &deltas);
+
+  auto same = [](const vector<Minimizer>& deltas1,
+                 const vector<Minimizer>& deltas2) {
+    if (deltas1.size() != deltas2.size()) return false;
+    for (size_t i = 0; i < deltas1.size(); ++i) {
+      const auto& delta1 = deltas1[i];
+      const auto& delta2 = deltas2[i];
+      if (delta1.range_ref_.start_ != delta2.range_ref_.start_ ||
+          delta1.range_ref_.end_ != delta2.range_ref_.end_ ||
+          delta1.range_seg_.start_ != delta2.range_seg_.start_ ||
+          delta1.range_seg_.end_ != delta2.range_seg_.end_) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // The k-line of the path moves by the size of each DEL, and back by that of
+  // each INS, in the order of ref.
+  vector<pair<size_t, int>> moves;
+  for (const auto& delta : expected.del_) {
+    moves.emplace_back(
+        delta.range_ref_.start_, static_cast<int>(delta.range_ref_.size()));
+  }
+  for (const auto& delta : expected.ins_) {
+    moves.emplace_back(
+        delta.range_ref_.start_, -static_cast<int>(delta.range_seg_.size()));
+  }
+  sort(moves.begin(), moves.end());
+  int k = 0, max_k = 0;
+  for (const auto& [start, shift] : moves) max_k = max(max_k, abs(k += shift));
+  Test::Expect(
+      __func__, true, max_k > static_cast<int>(Config::MYERS_BAND_WIDTH));
+  Test::Expect(__func__, true, same(expected.ins_, deltas.ins_));
+  Test::Expect(__func__, true, same(expected.del_, deltas.del_));
+
+  Logger::Info(__func__, "Passed");
+}
@@ -0,0 +1,143 @@
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logger.h"
+#include "sequence_reader.h"
+#include "test.h"
+
+using std::ifstream;
+using std::istreambuf_iterator;
+using std::min;
+using std::ofstream;
+using std::pair;
+using std::remove;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Write value as BGZF blocks of block_size bytes, and an empty end block.
+void WriteBgzf(const string& filename, const string& value, size_t block_size) {
+  ofstream out_file(filename, std::ios::binary);
+  auto write = [&](size_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i, value >>= 8) out_file.put(value & 0xff);
+  };
+
+  for (size_t pos = 0, size = 1; size; pos += size) {
+    size = min(block_size, value.size() - pos);
+    auto input_p = reinterpret_cast<const Bytef*>(value.data() + pos);
+    string data(compressBound(size), '\0');
+
+    z_stream stream = {};
+    deflateInit2(&stream, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    stream.next_in = const_cast<Bytef*>(input_p);
+    stream.avail_in = size;
+    stream.next_out = reinterpret_cast<Bytef*>(&data[0]);
+    stream.avail_out = data.size();
+    deflate(&stream, Z_FINISH);
+    data.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    // Magic, deflate, FEXTRA, no time, no flags, unknown OS and 6 extra bytes.
+    write(0x04088b1f, 4);
+    write(0, 4);
+    write(0xff00, 2);
+    write(6, 2);
+    // The BC subfield of 2 bytes, with the block size minus 1.
+    write(0x4342, 2);
+    write(2, 2);
+    write(data.size() + 25, 2);
+    out_file << data;
+    write(crc32(0, input_p, size), 4);
+    write(size, 4);
+  }
+}
+
+}  // namespace
+
+void Test::SequenceReaderTest() {
+  const string value =
+      ">chr1 wrapped\r\nACGT\r\nNNAC\r\n\n"
+      ">chr2\nTTTT\n"
+      "@read1 fastq\nACGTAC\nGT\n+\n@@@+\n@@@@\n"
+      ">chr3\n";
+
+  auto expected = vector<pair<string, string>>{
+      {"chr1", "ACGTNNAC"},
+      {"chr2", "TTTT"},
+      {"read1", "ACGTACGT"},
+      {"chr3", ""},
+  };
+
+  const string filename = "sequence_reader_test.fastq";
+  ofstream(filename) << value;
+
+  SequenceReader reader(filename);
+  vector<SequenceReader::Record> records;
+  Test::Expect(__func__, 2ul, reader.Read(&records, 10));
+  Test::Expect(__func__, 2ul, reader.Read(&records, 10));
+  Test::Expect(__func__, 0ul, reader.Read(&records, 10));
+  Test::Expect(__func__, true, static_cast<bool>(reader));
+  Test::Expect(__func__, reader.size(), reader.pos());
+
+  // The same records in plain, gzip and BGZF files.
+  const string gzip_filename = filename + ".gz";
+  const string bgzf_filename = filename + ".bgz";
+  auto gzip_file = gzopen(gzip_filename.c_str(), "wb");
+  gzwrite(gzip_file, value.data(), value.size());
+  gzclose(gzip_file);
+  WriteBgzf(bgzf_filename, value, 16);
+
+  auto formats = vector<pair<string, SequenceReader::Format>>{
+      {filename, SequenceReader::PLAIN},
+      {gzip_filename, SequenceReader::GZIP},
+      {bgzf_filename, SequenceReader::BGZF},
+  };
+  for (const auto& [test_filename, format] : formats) {
+    SequenceReader reader(test_filename);
+    Test::Expect(__func__, format, reader.format_);
+    for (const auto& [key, value] : expected) {
+      SequenceReader::Record record;
+      Test::Expect(__func__, true, reader.Read(&record));
+      Test::Expect(__func__, true, record.key_ == key);
+      Test::Expect(__func__, true, record.value_ == value);
+    }
+    SequenceReader::Record record;
+    Test::Expect(__func__, false, reader.Read(&record));
+    Test::Expect(__func__, true, static_cast<bool>(reader));
+  }
+
+  // Truncated and corrupted files fail instead of ending early.
+  auto read_all = [](const string& test_filename) {
+    SequenceReader reader(test_filename);
+    SequenceReader::Record record;
+    while (reader.Read(&record)) continue;
+    return static_cast<bool>(reader);
+  };
+  for (const auto& [test_filename, format] : formats) {
+    ifstream in_file(test_filename, std::ios::binary);
+    string data{istreambuf_iterator<char>(in_file), {}};
+    in_file.close();
+
+    auto size = data.size() / 2;
+    ofstream(test_filename, std::ios::binary) << data.substr(0, size);
+    Test::Expect(__func__, false, read_all(test_filename));
+
+    if (format != SequenceReader::PLAIN) {
+      // Flip a bit of the CRC of the last block, before the BGZF end block.
+      data[data.size() - (format == SequenceReader::BGZF ? 36 : 8)] ^= 1;
+      ofstream(test_filename, std::ios::binary) << data;
+      Test::Expect(__func__, false, read_all(test_filename));
+    }
+    remove(test_filename.c_str());
+  }
+
+  Logger::Info(__func__, "Passed");
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "logger.h"
+#include "sequence.h"
+#include "test.h"
+
+using std::out_of_range;
+using std::reverse;
+using std::string;
+using std::tuple;
+using std::vector;
+
+void Test::SequenceTest() {
+  const string value =
+      "NNTACGGTGCGCACCGGACGGCCGACCATTCGCCAGACGGCNNNNCGACCAATCGGGGACGGCATAN";
+  const Sequence sequence{value};
+
+  Test::Expect(__func__, value.size(), sequence.size());
+  Test::Expect(__func__, true, sequence.substr() == value);
+  Test::Expect(__func__, true, sequence.substr(30, 20) == value.substr(30, 20));
+  Test::Expect(__func__, true, sequence.substr(60, 20) == value.substr(60, 20));
+  Test::Expect(__func__, true, sequence.substr(value.size()).empty());
+
+  // Positions past the end throw, as std::string::substr does.
+  auto thrown = false;
+  try {
+    sequence.substr(value.size() + 1);
+  } catch (const out_of_range&) {
+    thrown = true;
+  }
+  Test::Expect(__func__, true, thrown);
+  for (auto i = 0ul; i < value.size(); ++i) {
+    Test::Expect(__func__, value[i], sequence[i]);
+  }
+
+  // {other, pos, that_pos, expected} of Sequence::Match.
+  auto tests = vector<tuple<string, size_t, size_t, size_t>>{
+      {value, 0, 0, value.size()},
+      {"GGTGCGCACCGGACGGCAGACC", 5, 0, 17},
+      {"CCAGACGGCTATGCGACCAATCGGGGACGGCATAC", 32, 0, 35},
+      {"TTCGCCAGACGGC", 28, 0, 13},
+  };
+
+  for (const auto& [other, pos, that_pos, expected] : tests) {
+    const Sequence that{other};
+    auto max_len = std::min(value.size() - pos, other.size() - that_pos);
+    Test::Expect(
+        __func__, expected, sequence.Match(pos, that, that_pos, max_len));
+  }
+
+  auto transform = [](string chain, Mode mode) {
+    if (mode & REVERSE) reverse(chain.begin(), chain.end());
+    if (mode & COMPLEMENT) {
+      for (auto&& base : chain) {
+        base = base == 'A' ? 'T'
+             : base == 'T' ? 'A'
+             : base == 'C' ? 'G'
+             : base == 'G' ? 'C'
+                           : base;
+      }
+    }
+    return chain;
+  };
+
+  for (auto mode : {NORMAL, REVERSE, COMPLEMENT, REVR_COMP}) {
+    auto expected = transform(value, mode);
+    const Sequence expected_sequence{expected};
+    auto transformed = sequence;
+    transformed.Transform(mode);
+
+    Test::Expect(__func__, true, transformed.substr() == expected);
+    Test::Expect(
+        __func__,
+        true,
+        sequence.substr(3, 40, mode) == transform(value.substr(3, 40), mode));
+    for (auto i = 0ul; i < value.size(); ++i) {
+      Test::Expect(__func__, expected_sequence.code(i), transformed.code(i));
+    }
+  }
+
+  // Sequences ending anywhere in a word are reversed in place alike, and keep
+  // the bits past their end clear.
+  for (auto size : {1ul, 31ul, 32ul, 33ul, 64ul, 65ul}) {
+    auto part = value.substr(value.size() - size);
+    Sequence reversed{part};
+    reversed.Transform(REVERSE);
+    Test::Expect(__func__, true, reversed.substr() == transform(part, REVERSE));
+    Test::Expect(__func__, 0ul, reversed.code(size) | reversed.code(size + 31));
+  }
+
+  // A reused sequence keeps no trace of its previous bases.
+  auto reused = sequence;
+  reused.Assign("ACGTAC");
+  Test::Expect(__func__, 6ul, reused.size());
+  Test::Expect(__func__, false, reused.HasUnknown(0, 6));
+  Test::Expect(__func__, true, reused.substr() == "ACGTAC");
+
+  Logger::Info(__func__, "Passed");
+}
@@ -2,6 +2,7 @@
 #define TESTS_UNIT_TEST_H_
 
 #include <cstdlib>
+#include <random>
 #include <string>
 
 #include "logger.h"
@@ -20,7 +21,27 @@ class Test {
     }
   }
 
+  // A random chain of size bases, drawn from bases with random_p.
+  static std::string RandomChain(
+      std::mt19937* random_p,
+      size_t size,
+      const std::string& bases = "ATCG") {
+    std::string chain;
+    for (size_t i = 0; i < size; ++i) {
+      chain += bases[(*random_p)() % bases.size()];
+    }
+    return chain;
+  }
+
+  static void ChainTest();
+  static void DeltaTest();
   static void HashTest();
+  static void IndexTest();
+  static void LcsTest();
+  static void MyersTest();
+  static void SequenceTest();
+  static void SequenceReaderTest();
+  static void TraTest();
 };
 
 #endif  // TESTS_UNIT_TEST_H_
@@ -0,0 +1,40 @@
+#include <random>
+#include <string>
+
+#include "dna.h"
+#include "logger.h"
+#include "sequence_key.h"
+#include "test.h"
+
+using std::mt19937;
+
+void Test::TraTest() {
+  mt19937 random(1);
+
+  // chr1 loses [1000, 1300), which shows up in chr2 with a few errors. An
+  // unrelated DEL of the same size must stay.
+  const Sequence ref1{RandomChain(&random, 3000)};
+  const Sequence ref2{RandomChain(&random, 3000)};
+  auto moved = ref1.substr(1000, 300);
+  for (size_t i = 0; i < moved.size(); i += 25) moved[i] = 'N';
+  const Sequence sv{moved};
+
+  auto key_ref1 = SequenceKey::Intern("ref1");
+  auto key_ref2 = SequenceKey::Intern("ref2");
+  auto key_sv = SequenceKey::Intern("sv");
+
+  Dna dna;
+  dna.ins_deltas_.Set(
+      key_ref2, {{2000, 2300, &ref2}, key_sv, {0, sv.size(), &sv}});
+  dna.del_deltas_.Set(
+      key_ref1, {{1000, 1300, &ref1}, key_sv, {1000, 1300, &ref1}});
+  dna.del_deltas_.Set(
+      key_ref2, {{500, 800, &ref2}, key_sv, {500, 800, &ref2}});
+  dna.FindTraDeltas();
+
+  Test::Expect(__func__, 0ul, dna.ins_deltas_.data_[key_ref2].size());
+  Test::Expect(__func__, 0ul, dna.del_deltas_.data_[key_ref1].size());
+  Test::Expect(__func__, 1ul, dna.del_deltas_.data_[key_ref2].size());
+
+  Logger::Info(__func__, "Passed");
+}